@@ -0,0 +1,488 @@
+#include "async_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+
+constexpr size_t IO_ALIGNMENT = 4096;
+
+// One read or write; buffer_index is the registered buffer data lies in, or -1
+struct IoRequest
+{
+    int fd;
+    bool write;
+    char* data;
+    size_t size;
+    off_t offset;
+    int buffer_index;
+};
+
+class IoQueue
+{
+public:
+    virtual ~IoQueue() = default;
+
+    // Register the staging buffers for fixed-buffer requests, where the backend has them
+    virtual bool register_buffers(const std::vector<iovec>&) { return false; }
+
+    virtual bool submit(const IoRequest& request, uint64_t tag) = 0;
+
+    // Wait for one completion: its tag and the byte count or -errno
+    virtual bool complete(uint64_t& tag, long& result) = 0;
+};
+
+#ifdef ASYNC_IO_URING
+
+class UringQueue : public IoQueue
+{
+public:
+    explicit UringQueue(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) return;
+
+        // Kernels 5.1 to 5.5 set up a ring but fail every plain read and write on it
+        if (!supports_opcodes())
+        {
+            release();
+            return;
+        }
+
+        sq_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) sq_bytes = cq_bytes = std::max(sq_bytes, cq_bytes);
+
+        sq_ring = mmap(nullptr, sq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_ring = single ? sq_ring
+                         : mmap(nullptr, cq_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        sqe_bytes = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqe_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ring);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~UringQueue() override { release(); }
+
+    bool ok() const { return ring_fd >= 0; }
+
+    bool register_buffers(const std::vector<iovec>& buffers) override
+    {
+        // Fails under a low RLIMIT_MEMLOCK; plain reads and writes work regardless
+        registered = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS,
+                             buffers.data(), static_cast<unsigned>(buffers.size())) == 0;
+        return registered;
+    }
+
+    bool submit(const IoRequest& request, uint64_t tag) override
+    {
+        // Callers keep no more requests in flight than the ring has entries
+        unsigned tail = *sq_tail;
+        unsigned index = tail & sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        bool fixed = registered && request.buffer_index >= 0;
+        if (request.write)
+            sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        else
+            sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = request.fd;
+        sqe->off = static_cast<uint64_t>(request.offset);
+        sqe->addr = reinterpret_cast<uint64_t>(request.data);
+        sqe->len = static_cast<uint32_t>(request.size);
+        if (fixed) sqe->buf_index = static_cast<uint16_t>(request.buffer_index);
+        sqe->user_data = tag;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0) < 0)
+        {
+            if (errno != EINTR && errno != EAGAIN) return false;
+        }
+        return true;
+    }
+
+    bool complete(uint64_t& tag, long& result) override
+    {
+        unsigned head = *cq_head;
+        while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            if (syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                return false;
+        }
+        const io_uring_cqe& cqe = cqes[head & cq_mask];
+        tag = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    // IORING_OP_READ and IORING_OP_WRITE arrived in 5.6 together with the probe, so a kernel
+    // that cannot answer the probe lacks them too
+    bool supports_opcodes() const
+    {
+        std::vector<uint64_t> storage((sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op)) /
+                                      sizeof(uint64_t) + 1, 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) return false;
+
+        auto supported = [probe](int op) { return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED); };
+        return supported(IORING_OP_READ) && supported(IORING_OP_WRITE) &&
+               supported(IORING_OP_READ_FIXED) && supported(IORING_OP_WRITE_FIXED);
+    }
+
+    void release()
+    {
+        if (sqes != MAP_FAILED && sqes != nullptr) munmap(sqes, sqe_bytes);
+        if (cq_ring != MAP_FAILED && cq_ring != nullptr && cq_ring != sq_ring) munmap(cq_ring, cq_bytes);
+        if (sq_ring != MAP_FAILED && sq_ring != nullptr) munmap(sq_ring, sq_bytes);
+        sqes = nullptr;
+        sq_ring = cq_ring = nullptr;
+        if (ring_fd >= 0) close(ring_fd);
+        ring_fd = -1;
+    }
+
+    int ring_fd = -1;
+    bool registered = false;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    size_t sq_bytes = 0, cq_bytes = 0, sqe_bytes = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+};
+
+#endif
+
+// pwrite/pread on a few worker threads, for hosts without io_uring
+class ThreadQueue : public IoQueue
+{
+public:
+    explicit ThreadQueue(int threads)
+    {
+        for (int i = 0; i < threads; ++i) workers.emplace_back([this] { run(); });
+    }
+
+    ~ThreadQueue() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    bool submit(const IoRequest& request, uint64_t tag) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.emplace_back(request, tag);
+        }
+        work_ready.notify_one();
+        return true;
+    }
+
+    bool complete(uint64_t& tag, long& result) override
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_ready.wait(lock, [this] { return !done.empty(); });
+        tag = done.front().first;
+        result = done.front().second;
+        done.pop_front();
+        return true;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            work_ready.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            auto [request, tag] = pending.front();
+            pending.pop_front();
+            lock.unlock();
+
+            ssize_t bytes = request.write ? pwrite(request.fd, request.data, request.size, request.offset)
+                                          : pread(request.fd, request.data, request.size, request.offset);
+            long result = (bytes < 0) ? -errno : static_cast<long>(bytes);
+
+            lock.lock();
+            done.emplace_back(tag, result);
+            done_ready.notify_one();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable done_ready;
+    std::deque<std::pair<IoRequest, uint64_t>> pending;
+    std::deque<std::pair<uint64_t, long>> done;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+std::unique_ptr<IoQueue> make_queue(const AsyncIoOptions& options)
+{
+    int depth = std::max(1, options.depth);
+#ifdef ASYNC_IO_URING
+    if (options.backend != "threads")
+    {
+        auto ring = std::make_unique<UringQueue>(static_cast<unsigned>(depth));
+        if (ring->ok()) return ring;
+    }
+#endif
+    return std::make_unique<ThreadQueue>(std::min(depth, 4));
+}
+
+// Issue the requests with at most depth in flight, resubmitting the rest of short transfers.
+// False on the first error, or a read that hits the end of the file.
+bool run_requests(IoQueue& queue, std::vector<IoRequest>& requests, int depth)
+{
+    size_t next = 0;
+    size_t in_flight = 0;
+    bool ok = true;
+    while (next < requests.size() || in_flight > 0)
+    {
+        while (ok && next < requests.size() && in_flight < static_cast<size_t>(depth))
+        {
+            if (!queue.submit(requests[next], next)) return false;
+            ++next;
+            ++in_flight;
+        }
+        if (in_flight == 0) break;
+
+        uint64_t tag;
+        long result;
+        if (!queue.complete(tag, result)) return false;
+        --in_flight;
+
+        IoRequest& request = requests[tag];
+        if (result <= 0)
+        {
+            ok = false;
+            continue;
+        }
+        if (static_cast<size_t>(result) < request.size)
+        {
+            request.data += result;
+            request.size -= static_cast<size_t>(result);
+            request.offset += result;
+            if (!ok || !queue.submit(request, tag))
+                ok = false;
+            else
+                ++in_flight;
+        }
+    }
+    return ok;
+}
+
+struct AlignedFree
+{
+    void operator()(char* p) const { std::free(p); }
+};
+
+bool write_file(const std::string& path, const char* data, size_t size, const std::string& suffix,
+                const AsyncIoOptions& options)
+{
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (options.direct)
+    {
+        fd = open(path.c_str(), flags | O_DIRECT, 0644);
+        direct = (fd >= 0);
+    }
+#endif
+    if (fd < 0) fd = open(path.c_str(), flags, 0644);
+    if (fd < 0) return false;
+
+    int depth = std::max(1, options.depth);
+    size_t block = std::max(IO_ALIGNMENT, options.block_bytes / IO_ALIGNMENT * IO_ALIGNMENT);
+    size_t total = size + suffix.size();
+    std::unique_ptr<IoQueue> queue = make_queue(options);
+
+    // Staging blocks, registered once; reused round robin as the requests complete
+    int block_count = static_cast<int>(std::min<size_t>(depth, (total + block - 1) / block));
+    std::vector<std::unique_ptr<char, AlignedFree>> blocks;
+    std::vector<iovec> buffers;
+    for (int i = 0; i < block_count; ++i)
+    {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, IO_ALIGNMENT, block) != 0)
+        {
+            close(fd);
+            return false;
+        }
+        blocks.emplace_back(static_cast<char*>(memory));
+        buffers.push_back({memory, block});
+    }
+    if (block_count > 0) queue->register_buffers(buffers);
+
+    // Refill each block as its write completes, so depth writes stay in flight
+    std::vector<IoRequest> requests(block_count);
+    std::vector<int> free_blocks;
+    for (int i = block_count - 1; i >= 0; --i) free_blocks.push_back(i);
+    bool ok = true;
+    size_t position = 0;
+    int in_flight = 0;
+    while ((ok && position < total) || in_flight > 0)
+    {
+        while (ok && position < total && !free_blocks.empty())
+        {
+            int i = free_blocks.back();
+            free_blocks.pop_back();
+            size_t length = std::min(block, total - position);
+            char* buffer = blocks[i].get();
+            size_t from_data = (position < size) ? std::min(length, size - position) : 0;
+            std::memcpy(buffer, data + position, from_data);
+            if (length > from_data)
+                std::memcpy(buffer + from_data, suffix.data() + (position + from_data - size), length - from_data);
+            size_t request_size = length;
+            if (direct && length % IO_ALIGNMENT != 0)
+            {
+                request_size = (length + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+                std::memset(buffer + length, 0, request_size - length);
+            }
+            requests[i] = {fd, true, buffer, request_size, static_cast<off_t>(position), i};
+            if (!queue->submit(requests[i], i))
+            {
+                ok = false;
+                break;
+            }
+            position += length;
+            ++in_flight;
+        }
+        if (in_flight == 0) break;
+
+        uint64_t tag;
+        long result;
+        if (!queue->complete(tag, result))
+        {
+            ok = false;
+            break;
+        }
+        --in_flight;
+        IoRequest& request = requests[tag];
+        if (result <= 0)
+        {
+            ok = false;
+        }
+        else if (static_cast<size_t>(result) < request.size)
+        {
+            request.data += result;
+            request.size -= static_cast<size_t>(result);
+            request.offset += result;
+            if (ok && queue->submit(request, tag))
+                ++in_flight;
+            else
+                ok = false;
+        }
+        else
+        {
+            free_blocks.push_back(static_cast<int>(tag));
+        }
+    }
+
+    // Cut the zero padding of an O_DIRECT tail back off
+    if (ok && direct && total % IO_ALIGNMENT != 0) ok = (ftruncate(fd, static_cast<off_t>(total)) == 0);
+    queue.reset();
+    return (close(fd) == 0) && ok;
+}
+
+} // namespace
+
+const char* async_io_backend(const AsyncIoOptions& options)
+{
+#ifdef ASYNC_IO_URING
+    if (options.backend != "threads" && UringQueue(1).ok()) return "io_uring";
+#endif
+    return "threads";
+}
+
+AsyncFileWrite::~AsyncFileWrite()
+{
+    wait();
+}
+
+void AsyncFileWrite::start(const std::string& path, const char* data, size_t size, const std::string& suffix,
+                           const AsyncIoOptions& options)
+{
+    wait();
+    result = false;
+    worker = std::thread([this, path, data, size, suffix, options] {
+        result = write_file(path, data, size, suffix, options);
+    });
+}
+
+bool AsyncFileWrite::wait()
+{
+    if (worker.joinable()) worker.join();
+    return result;
+}
+
+bool async_read_file(const std::string& path, off_t offset, char* buffer, size_t size, const AsyncIoOptions& options)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    int depth = std::max(1, options.depth);
+    size_t block = std::max(IO_ALIGNMENT, options.block_bytes);
+    std::vector<IoRequest> requests;
+    for (size_t position = 0; position < size; position += block)
+    {
+        requests.push_back({fd, false, buffer + position, std::min(block, size - position),
+                            offset + static_cast<off_t>(position), -1});
+    }
+
+    std::unique_ptr<IoQueue> queue = make_queue(options);
+    bool ok = run_requests(*queue, requests, depth);
+    queue.reset();
+    close(fd);
+    return ok;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <sys/types.h>
+
+// Asynchronous file I/O for result files and reference reads.
+//
+// On Linux the requests go to an io_uring (raw syscalls, no liburing): the staging blocks are
+// registered with the ring once and written with IORING_OP_WRITE_FIXED, and at most depth
+// blocks are in flight. Where io_uring is missing or blocked (old kernels, container seccomp
+// profiles) a small pool of threads issues the same requests with pwrite/pread.
+//
+// Writes copy the caller's bytes into aligned staging blocks, so O_DIRECT works for any
+// length: the last block is padded to the 4096 byte alignment and the file truncated back
+// afterwards. File systems that refuse O_DIRECT (tmpfs) get a buffered write instead.
+
+struct AsyncIoOptions
+{
+    int depth = 8;                          // Requests in flight at most
+    size_t block_bytes = 4 << 20;           // Bytes per request, a multiple of 4096
+    bool direct = false;                    // Open written files with O_DIRECT
+    std::string backend = "auto";           // "auto", "uring" or "threads"
+};
+
+// Backend the options select on this host: "io_uring" or "threads"
+const char* async_io_backend(const AsyncIoOptions& options);
+
+// One file written by a background thread while the caller carries on
+class AsyncFileWrite
+{
+public:
+    AsyncFileWrite() = default;
+    ~AsyncFileWrite();
+
+    AsyncFileWrite(const AsyncFileWrite&) = delete;
+    AsyncFileWrite& operator=(const AsyncFileWrite&) = delete;
+
+    // Create or truncate path and write size bytes of data followed by suffix. data must stay
+    // valid until wait(); suffix is copied. Returns once the write is under way.
+    void start(const std::string& path, const char* data, size_t size, const std::string& suffix,
+               const AsyncIoOptions& options);
+
+    // Block until the write finishes. True when every byte reached the file.
+    bool wait();
+
+private:
+    std::thread worker;
+    bool result = false;
+};
+
+// Read size bytes at offset of path into buffer with up to depth block reads in flight.
+// False on any error or when the file ends first.
+bool async_read_file(const std::string& path, off_t offset, char* buffer, size_t size,
+                     const AsyncIoOptions& options);
+
+#endif
@@ -0,0 +1,85 @@
+#include "batch_targets.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Positive decimal number, the whole token
+static bool parse_places(const std::string& text, long long& value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    try
+    {
+        value = std::stoll(text);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return value > 0;
+}
+
+bool load_batch_targets(const std::string& filename, std::vector<BatchTarget>& targets)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Error: Could not open batch file: " << filename << "\n";
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string target, output, extra;
+        if (!(fields >> target)) continue;
+        fields >> output >> extra;
+
+        BatchTarget entry;
+        size_t dash = target.find('-');
+        bool ok = extra.empty();
+        if (dash == std::string::npos)
+        {
+            ok = ok && parse_places(target, entry.last);
+        }
+        else
+        {
+            ok = ok && parse_places(target.substr(0, dash), entry.first) &&
+                 parse_places(target.substr(dash + 1), entry.last) && entry.first <= entry.last;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Error: " << filename << ":" << line_number << ": expected <N> or <first>-<last> "
+                      << "and an optional output file, got: " << line << "\n";
+            return false;
+        }
+
+        entry.output = output.empty() ? "computed_pi_" + target + ".txt" : output;
+        targets.push_back(entry);
+    }
+
+    if (targets.empty())
+    {
+        std::cerr << "Error: No targets in batch file: " << filename << "\n";
+        return false;
+    }
+    return true;
+}
+
+long long batch_max_decimal_places(const std::vector<BatchTarget>& targets)
+{
+    long long largest = 0;
+    for (const auto& target : targets)
+    {
+        largest = std::max(largest, target.last);
+    }
+    return largest;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef BATCH_TARGETS_HPP
+#define BATCH_TARGETS_HPP
+
+#include <string>
+#include <vector>
+
+// Targets for --batch <file>: one computation at the largest size, one output file per target.
+//
+// One target per line, blank lines and # comments ignored:
+//   <N> [output]            "3." and the first N decimal places (default computed_pi_<N>.txt)
+//   <first>-<last> [output] decimal places first..last, digits only (default computed_pi_<first>-<last>.txt)
+// Decimal places count from 1, the first digit after "3.".
+
+struct BatchTarget
+{
+    long long first = 0;                // 0 for a prefix including "3."
+    long long last = 0;                 // Last decimal place written
+    std::string output;
+};
+
+// Parse the file into targets. Prints the offending line and returns false on errors.
+bool load_batch_targets(const std::string& filename, std::vector<BatchTarget>& targets);
+
+// Decimal places needed to cover every target
+long long batch_max_decimal_places(const std::vector<BatchTarget>& targets);
+
+#endif
@@ -0,0 +1,283 @@
+// Microbenchmarks for the Chudnovsky term kernels and the GMP/MPFR primitives they use.
+//
+// Build with "make bench" and run ./calculate_pi_bench [options]
+// The numbers are intended to compare kernel changes without a full pi run.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <gmp.h>
+#include <mpfr.h>
+
+#include "globals.hpp"
+#include "chudnovsky.hpp"
+#include "ntt_multiply.hpp"
+#include "hypergeometric.hpp"
+
+using bench_clock = std::chrono::steady_clock;
+
+// Minimum wall time spent on each measurement so short operations are averaged.
+static double min_sample_seconds = 0.2;
+static long long decimal_places = 10000;
+static mpfr_prec_t working_prec = 0;
+
+static double seconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// Repeat an operation until min_sample_seconds has passed and return ns per call.
+template <typename Op>
+static double time_per_call_ns(Op op)
+{
+    long long calls = 0;
+    auto start = bench_clock::now();
+    double elapsed = 0.0;
+    do
+    {
+        op();
+        ++calls;
+        elapsed = seconds_since(start);
+    } while (elapsed < min_sample_seconds);
+    return elapsed * 1e9 / static_cast<double>(calls);
+}
+
+// Time a term kernel over [k_start, k_start + count) and return ns per term.
+template <typename Kernel>
+static double time_term_kernel_ns(Kernel kernel, unsigned long k_start, unsigned long count)
+{
+    long long terms = 0;
+    auto start = bench_clock::now();
+    double elapsed = 0.0;
+    do
+    {
+        for (unsigned long k = k_start; k < k_start + count; ++k)
+        {
+            kernel(k);
+            ++terms;
+        }
+        elapsed = seconds_since(start);
+    } while (elapsed < min_sample_seconds);
+    return elapsed * 1e9 / static_cast<double>(terms);
+}
+
+// Log-log slope between two measurements, i.e. the exponent in time ~ k^slope.
+static double scaling_exponent(double x0, double t0, double x1, double t1)
+{
+    if (x0 <= 0 || t0 <= 0 || x1 <= x0) return 0.0;
+    return std::log(t1 / t0) / std::log(x1 / x0);
+}
+
+static void bench_term_kernels(unsigned long max_k, unsigned long window)
+{
+    std::cout << "\n--- Term kernels (precision " << working_prec << " bits) ---\n";
+    std::cout << std::setw(12) << "k" << std::setw(22) << "compute_term ns/term" << std::setw(10) << "slope"
+              << std::setw(26) << "compute_chudnovsky_term" << std::setw(10) << "slope" << "\n";
+
+    ChudnovskyTermCalculator calculator(working_prec, debug_level);
+    ChudnovskyScratchpad scratch(working_prec);
+    mpfr_t term;
+    mpfr_init2(term, working_prec);
+
+    double prev_k = 0, prev_member = 0, prev_free = 0;
+
+    for (unsigned long k = 1; k <= max_k; k *= 10)
+    {
+        double member_ns = time_term_kernel_ns([&](unsigned long kk) { calculator.compute_term(term, kk, scratch); }, k, window);
+        double free_ns   = time_term_kernel_ns([&](unsigned long kk) { compute_chudnovsky_term(term, static_cast<long>(kk), scratch); }, k, window);
+
+        std::cout << std::setw(12) << k
+                  << std::setw(22) << std::fixed << std::setprecision(0) << member_ns
+                  << std::setw(10) << std::setprecision(2) << scaling_exponent(prev_k, prev_member, k, member_ns)
+                  << std::setw(26) << std::setprecision(0) << free_ns
+                  << std::setw(10) << std::setprecision(2) << scaling_exponent(prev_k, prev_free, k, free_ns) << "\n";
+
+        prev_k = static_cast<double>(k);
+        prev_member = member_ns;
+        prev_free = free_ns;
+    }
+
+    mpfr_clear(term);
+}
+
+// Binary splitting leaves: SERIES_LEAF_BATCH terms one mpz leaf at a time (merged pairwise like
+// series_split) against series_leaf_batch, which builds the factors natively first.
+static void bench_series_leaves(unsigned long max_k)
+{
+    std::cout << "\n--- Binary splitting leaves (" << SERIES_LEAF_BATCH << " terms, ns per term) ---\n";
+    std::cout << std::setw(12) << "k" << std::setw(16) << "per term" << std::setw(16) << "batched" << "\n";
+
+    mpz_t P, Q, T, P2, Q2, T2;
+    mpz_inits(P, Q, T, P2, Q2, T2, nullptr);
+
+    // Past the limit the batch falls back to mpz leaves, which is not what this compares
+    const unsigned long limit = series_leaf_batch_limit<ChudnovskyPi>();
+    if (max_k + SERIES_LEAF_BATCH - 1 > limit)
+    {
+        max_k = limit - (SERIES_LEAF_BATCH - 1);
+        std::cout << "(k capped at " << max_k << ", the native batch limit)\n";
+    }
+
+    for (unsigned long k = 1; k <= max_k; k *= 10)
+    {
+        double single_ns = time_per_call_ns([&] {
+            series_leaf<ChudnovskyPi>(k, P, Q, T);
+            for (unsigned long j = k + 1; j < k + SERIES_LEAF_BATCH; ++j)
+            {
+                series_leaf<ChudnovskyPi>(j, P2, Q2, T2);
+                mpz_mul(T, T, Q2);
+                mpz_mul(T2, T2, P);
+                mpz_add(T, T, T2);
+                mpz_mul(P, P, P2);
+                mpz_mul(Q, Q, Q2);
+            }
+        });
+        double batch_ns = time_per_call_ns([&] { series_leaf_batch<ChudnovskyPi>(k, k + SERIES_LEAF_BATCH, P, Q, T); });
+
+        std::cout << std::setw(12) << k << std::fixed << std::setprecision(1)
+                  << std::setw(16) << single_ns / SERIES_LEAF_BATCH << std::setw(16) << batch_ns / SERIES_LEAF_BATCH << "\n";
+    }
+
+    mpz_clears(P, Q, T, P2, Q2, T2, nullptr);
+}
+
+static void bench_mpz_primitives(mpfr_prec_t max_bits)
+{
+    std::cout << "\n--- GMP mpz primitives (operands of n bits, NTT kernel " << ntt_kernel_name() << ") ---\n";
+    std::cout << std::setw(12) << "bits" << std::setw(16) << "mul ns" << std::setw(16) << "ntt mul ns"
+              << std::setw(16) << "tdiv_q ns" << std::setw(16) << "fac_ui ns" << "\n";
+
+    gmp_randstate_t rng;
+    gmp_randinit_default(rng);
+    mpz_t a, b, num, r;
+    mpz_inits(a, b, num, r, nullptr);
+
+    for (mpfr_prec_t bits = 1024; bits <= max_bits; bits *= 4)
+    {
+        mpz_urandomb(a, rng, bits);
+        mpz_urandomb(b, rng, bits);
+        mpz_setbit(b, bits - 1);
+        mpz_mul(num, a, b);   // 2n-bit numerator / n-bit divisor like the term divisions
+
+        double mul_ns = time_per_call_ns([&] { mpz_mul(r, a, b); });
+        double ntt_ns = time_per_call_ns([&] { ntt_multiply(r, a, b); });
+        double div_ns = time_per_call_ns([&] { mpz_tdiv_q(r, num, b); });
+
+        // Factorial whose result is roughly the operand size (log2(n!) ~ n log2 n)
+        unsigned long fac_n = 16;
+        while (fac_n * std::log2(static_cast<double>(fac_n)) < static_cast<double>(bits)) fac_n *= 2;
+        double fac_ns = time_per_call_ns([&] { mpz_fac_ui(r, fac_n); });
+
+        std::cout << std::setw(12) << bits << std::fixed << std::setprecision(0)
+                  << std::setw(16) << mul_ns << std::setw(16) << ntt_ns << std::setw(16) << div_ns
+                  << std::setw(16) << fac_ns << "\n";
+    }
+
+    mpz_clears(a, b, num, r, nullptr);
+    gmp_randclear(rng);
+}
+
+static void bench_mpfr_primitives(mpfr_prec_t max_bits)
+{
+    std::cout << "\n--- MPFR primitives (precision n bits) ---\n";
+    std::cout << std::setw(12) << "bits" << std::setw(16) << "mul ns" << std::setw(16) << "div ns"
+              << std::setw(16) << "sqrt_ui ns" << std::setw(16) << "add ns" << "\n";
+
+    gmp_randstate_t rng;
+    gmp_randinit_default(rng);
+
+    for (mpfr_prec_t bits = 1024; bits <= max_bits; bits *= 4)
+    {
+        mpfr_t a, b, r;
+        mpfr_inits2(bits, a, b, r, (mpfr_ptr) 0);
+        mpfr_urandomb(a, rng);
+        mpfr_urandomb(b, rng);
+        mpfr_add_ui(b, b, 1, MPFR_RNDN);
+
+        double mul_ns  = time_per_call_ns([&] { mpfr_mul(r, a, b, MPFR_RNDN); });
+        double div_ns  = time_per_call_ns([&] { mpfr_div(r, a, b, MPFR_RNDN); });
+        double sqrt_ns = time_per_call_ns([&] { mpfr_sqrt_ui(r, 10005, MPFR_RNDN); });
+        double add_ns  = time_per_call_ns([&] { mpfr_add(r, a, b, MPFR_RNDN); });
+
+        std::cout << std::setw(12) << bits << std::fixed << std::setprecision(0)
+                  << std::setw(16) << mul_ns << std::setw(16) << div_ns
+                  << std::setw(16) << sqrt_ns << std::setw(16) << add_ns << "\n";
+
+        mpfr_clears(a, b, r, (mpfr_ptr) 0);
+    }
+
+    gmp_randclear(rng);
+}
+
+static void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n\n"
+              << "Options:\n"
+              << "  --digits <n>       Decimal places used to size the working precision (default 10000)\n"
+              << "  --max-k <k>        Largest k sampled for the term kernels (default 1000)\n"
+              << "  --window <n>       Consecutive terms timed at each k (default 8)\n"
+              << "  --min-time <sec>   Minimum time spent per measurement (default 0.2)\n"
+              << "  --skip-terms       Only run the GMP/MPFR primitive benchmarks\n"
+              << "  -h, --help         Show this help message\n";
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned long max_k = 1000;
+    unsigned long window = 8;
+    bool skip_terms = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        try
+        {
+            if (arg == "--digits" && i + 1 < argc)        decimal_places = std::stoll(argv[++i]);
+            else if (arg == "--max-k" && i + 1 < argc)    max_k = std::stoul(argv[++i]);
+            else if (arg == "--window" && i + 1 < argc)   window = std::stoul(argv[++i]);
+            else if (arg == "--min-time" && i + 1 < argc) min_sample_seconds = std::stod(argv[++i]);
+            else if (arg == "--skip-terms")               skip_terms = true;
+            else if (arg == "-h" || arg == "--help")
+            {
+                print_usage(argv[0]);
+                return 0;
+            }
+            else
+            {
+                std::cerr << "Error: Unknown option: " << arg << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (decimal_places <= 0 || window == 0 || max_k == 0)
+    {
+        std::cerr << "Error: --digits, --max-k and --window must be positive.\n";
+        return 1;
+    }
+
+    working_prec = get_chudnovsky_precision(decimal_places);
+    mpfr_set_default_prec(working_prec);
+
+    std::cout << "calculate_pi microbenchmarks: " << decimal_places << " decimal places, "
+              << working_prec << " bit working precision\n";
+
+    if (!skip_terms)
+    {
+        bench_term_kernels(max_k, window);
+        bench_series_leaves(max_k * 100);
+    }
+    bench_mpz_primitives(working_prec);
+    bench_mpfr_primitives(working_prec);
+
+    return 0;
+}
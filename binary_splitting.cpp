@@ -0,0 +1,153 @@
+#include "binary_splitting.hpp"
+#include "hypergeometric.hpp"
+#include "pi_cache.hpp"
+#include "series_shards.hpp"
+#include "globals.hpp"
+#include "instrumentation.hpp"
+#include "ntt_multiply.hpp"
+#include "self_check.hpp"
+
+#include <iostream>
+#include <string>
+
+SeriesState::SeriesState()
+{
+    mpz_init_set_ui(P, 1);
+    mpz_init_set_ui(Q, 1);
+    mpz_init(T);
+}
+
+SeriesState::~SeriesState()
+{
+    mpz_clears(P, Q, T, nullptr);
+}
+
+void SeriesState::swap(SeriesState& other)
+{
+    std::swap(begin, other.begin);
+    std::swap(end, other.end);
+    mpz_swap(P, other.P);
+    mpz_swap(Q, other.Q);
+    mpz_swap(T, other.T);
+}
+
+unsigned long chudnovsky_terms_for_digits(long long decimal_places)
+{
+    return series_terms_for_digits<ChudnovskyPi>(decimal_places);
+}
+
+void merge_series(SeriesState& left, const SeriesState& right)
+{
+    // T = T1 Q2 + P1 T2 first, it needs the old P1
+    mpz_t product;
+    mpz_init(product);
+    big_multiply(product, left.P, right.T);
+    big_multiply(left.T, left.T, right.Q);
+    big_add(left.T, left.T, product);
+    mpz_clear(product);
+
+    big_multiply(left.P, left.P, right.P);
+    big_multiply(left.Q, left.Q, right.Q);
+    if (left.begin == left.end) left.begin = right.begin;
+    left.end = right.end;
+}
+
+PiStatus binary_split_range(PiContext& context, unsigned long begin, unsigned long end, SeriesState& out)
+{
+    return series_split_range<ChudnovskyPi>(context, begin, end, out);
+}
+
+void pi_from_series(const SeriesState& series, mpfr_t pi)
+{
+    TraceSpan division_span("division");
+    ChudnovskyPi::finish(pi, series.Q, series.T);
+}
+
+PiStatus calculate_pi_binary_splitting(PiContext& context, mpfr_t pi)
+{
+    const PiOptions& options = context.options();
+    const int debug_level = options.debug_level;
+    const std::string& cache_dir = options.cache_dir;
+    unsigned long needed = chudnovsky_terms_for_digits(options.decimal_places);
+    uint64_t unrecovered = self_check_unrecovered();
+
+    // The terms were computed elsewhere as shards (--merge)
+    if (!options.merge_dir.empty())
+    {
+        SeriesState series;
+        PiStatus status = merge_shards(options.merge_dir, needed, series, debug_level);
+        if (status != PiStatus::Ok) return status;
+        if (self_check_unrecovered() != unrecovered)
+        {
+            self_check_report_discarded("merged series state");
+            return PiStatus::Error;
+        }
+        pi_from_series(series, pi);
+        return PiStatus::Ok;
+    }
+
+    // Start from the saved state when the cache has one
+    SeriesState series;
+    if (!cache_dir.empty() && cache_load_series(cache_dir, series) && series.begin != 0)
+    {
+        SeriesState empty;
+        series.swap(empty);
+    }
+
+    if (debug_level >= 1)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        if (series.end >= needed)
+            std::cerr << "[Cache] Saved state covers " << series.end << " terms, " << needed << " needed: no new terms\n";
+        else if (series.end > 0)
+            std::cerr << "[Cache] Extending saved state from k = " << series.end << " to " << needed << "\n";
+        else
+            std::cerr << "[calculate_pi_binary_splitting] " << needed << " terms, working_prec = "
+                      << context.precision() << " bits\n";
+    }
+
+    if (series.end < needed)
+    {
+        context.set_progress_total(needed - series.end);
+
+        SeriesState extension;
+        PiStatus status = binary_split_range(context, series.end, needed, extension);
+        if (status != PiStatus::Ok) return status;
+
+        {
+            TraceSpan merge_span("merge");
+            merge_series(series, extension);
+        }
+
+        // A wrong state must not reach the cache, where later runs would extend it
+        if (self_check_unrecovered() != unrecovered)
+        {
+            self_check_report_discarded("series state (not cached)");
+            return PiStatus::Error;
+        }
+
+        if (!cache_dir.empty() && !cache_store_series(cache_dir, series))
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cerr << "⚠️ Warning: Could not save the series state in " << cache_dir << "\n";
+        }
+    }
+
+    pi_from_series(series, pi);
+    return PiStatus::Ok;
+}
+
+PiStatus calculate_constant_binary_splitting(PiContext& context, mpfr_t result)
+{
+    // One instantiation per series: the leaves multiply by compile-time constants
+    switch (context.options().constant)
+    {
+        case PiConstant::Pi:        return series_compute<ChudnovskyPi>(context, result);
+        case PiConstant::E:         return series_compute<SeriesE>(context, result);
+        case PiConstant::Sqrt2:     return series_compute<SeriesSqrt2>(context, result);
+        case PiConstant::Log2:      return series_compute<SeriesLog2>(context, result);
+        case PiConstant::Zeta3:     return series_compute<SeriesZeta3>(context, result);
+        case PiConstant::Catalan:   return series_compute<SeriesCatalan>(context, result);
+    }
+    return PiStatus::InvalidArgument;
+}
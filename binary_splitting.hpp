@@ -0,0 +1,53 @@
+#pragma once
+#ifndef BINARY_SPLITTING_HPP
+#define BINARY_SPLITTING_HPP
+
+#include <gmp.h>
+#include <mpfr.h>
+#include "libpi.hpp"
+
+// Chudnovsky series by binary splitting over exact integers (-m binary_splitting). The same
+// engine sums the other constants' series, see hypergeometric.hpp.
+//
+// For the terms k in [begin, end) the state holds three integers with
+//     P = prod p(k),  Q = prod q(k),  T = sum over k of (+/-) P(begin, k+1) Q(k+1, end) (A + B k)
+// where p(k) = (6k-5)(2k-1)(6k-1), q(k) = k^3 C^3 / 24 (p = q = 1 for k = 0).
+// Adjacent ranges combine exactly:
+//     P = P1 P2,  Q = Q1 Q2,  T = T1 Q2 + P1 T2
+// so a result for [0, N) is extended to [0, M) by computing [N, M) alone and merging once.
+// For a state starting at k = 0, pi = 426880 sqrt(10005) Q / T.
+
+struct SeriesState
+{
+    unsigned long begin = 0;
+    unsigned long end = 0;              // Terms [begin, end); begin == end is the empty series
+    mpz_t P, Q, T;
+
+    SeriesState();                      // Empty series: P = Q = 1, T = 0 (the merge identity)
+    ~SeriesState();
+
+    SeriesState(const SeriesState&) = delete;
+    SeriesState& operator=(const SeriesState&) = delete;
+
+    void swap(SeriesState& other);
+};
+
+// Terms needed for decimal_places correct digits (about 14.18 digits per term)
+unsigned long chudnovsky_terms_for_digits(long long decimal_places);
+
+// Compute terms [begin, end) into out, split over the context's thread budget
+PiStatus binary_split_range(PiContext& context, unsigned long begin, unsigned long end, SeriesState& out);
+
+// left := left followed by right (right.begin must equal left.end)
+void merge_series(SeriesState& left, const SeriesState& right);
+
+// pi at precision bits from a state that starts at k = 0
+void pi_from_series(const SeriesState& series, mpfr_t pi);
+
+// Engine entry. With options().cache_dir set, starts from the saved state and saves the extended one.
+PiStatus calculate_pi_binary_splitting(PiContext& context, mpfr_t pi);
+
+// options().constant by its series in series_constants.hpp (no cache)
+PiStatus calculate_constant_binary_splitting(PiContext& context, mpfr_t result);
+
+#endif
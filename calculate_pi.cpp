@@ -16,9 +16,31 @@
 #include <mutex>
 #include <getopt.h> // Add this at the top
 #include <csignal>
+#include <optional>
+#include <condition_variable>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "globals.hpp"
+#include "libpi.hpp"
 #include "chudnovsky.hpp"
+#include "instrumentation.hpp"
+#include "system_sampler.hpp"
+#include "power_monitor.hpp"
+#include "metrics_export.hpp"
+#include "thread_placement.hpp"
+#include "container_limits.hpp"
+#include "digit_server.hpp"
+#include "batch_targets.hpp"
+#include "ntt_multiply.hpp"
+#include "series_shards.hpp"
+#include "async_io.hpp"
+#include "digit_index.hpp"
+#include "host_profile.hpp"
+#include "self_check.hpp"
 
 static_assert(true, "Header included");
 
@@ -29,49 +51,64 @@ namespace fs = std::filesystem;
 std::string version = "1.1.0";
 std::string calculation_method = "gauss_legendre";  // Default calculation method
 std::atomic <bool> keep_monitoring(true);           // Shared flag to stop monitoring thread
-std::atomic <long long> iteration_counter(0);       // Global counter
-std::atomic <long long> iterations(0);              // Ensure updates are visible to monitoring
 //std::string reference_filename = "Pi-Dec-Chudnovsky_01.txt"; // Default
 std::string reference_filename = "pi_reference_1M.txt"; // Default
-std::atomic <bool> stop_requested(false);
-std::mutex console_mutex;                           // Used to limit console output to a single thread at a time.
 bool use_dynamic;                                   // Flag to indicate if chudnovsky dynamic thread allocation is used.
-
-// External variables defined in globals.hpp
-int debug_level = 0;                                // Debug level passed in from command line
-bool use_multithreading = false;
-long long decimal_places = 1;
+std::string trace_filename;                         // Chrome trace output file (--trace), empty = disabled
+bool use_perf_counters = false;                     // Hardware counters per phase (--perf-counters)
+double monitor_interval_seconds = 10.0;             // Seconds between monitoring samples (--monitor-interval)
+std::mutex monitor_mutex;                           // Guards the monitoring thread's wait
+std::condition_variable monitor_cv;                 // Wakes the monitoring thread early when stopping
+SystemSampler system_sampler;                       // Temperature, frequency and memory samples
+bool use_energy = false;                            // RAPL energy accounting (--energy)
+std::string metrics_filename;                       // Metrics output file (--metrics-file), empty = disabled
+std::string metrics_format;                         // "prom" or "json" (--metrics-format), empty = from extension
+MetricsExporter metrics_exporter;                   // Written by the monitoring thread each interval
+bool use_pinning = false;                           // Pin worker threads to CPUs (--pin)
+bool skip_smt = false;                              // Only one worker per physical core (--skip-smt)
+bool use_numa = false;                              // NUMA memory policy and per-node merges (--numa)
+long long decimal_places = 1;                       // Requested decimal places
 int thread_count = 0;                               // Default is 0 = auto-detect based on CPU cores
-mpfr_prec_t working_prec = 0;
-
-struct RaplDomain
-{
-    std::string name;
-    std::string energy_path;
-    long long accumulated_energy_uj = 0;
-    double last_power_watts = 0.0;
-};
-
-// Declare static variables for power monitoring function
-static auto last_power_check_time = std::chrono::steady_clock::now();
-std::vector<RaplDomain> rapl_domains;
+PiContext* pi_context = nullptr;                    // Running computation, for Ctrl+C and the monitor
+std::string serve_socket;                           // Unix socket for daemon mode (--serve), empty = disabled
+long long serve_max_digits = 0;                     // Largest computation a client may trigger (--serve-max)
+std::string cache_dir;                              // Persistent result cache (--cache-dir), empty = disabled
+std::string batch_filename;                         // Targets file (--batch), empty = single run
+std::vector<BatchTarget> batch_targets;             // Outputs cut from one computation in batch mode
+int output_base = 10;                               // --base: 2..62, or 256 for raw bytes
+std::string constant_name = "pi";                   // --constant: pi, e, sqrt2, log2, zeta3, catalan
+PiConstant constant = PiConstant::Pi;
+int leaf_size = 32;                                 // Binary splitting terms per leaf (--leaf-size)
+int shard_index = -1;                               // --shard i/N: this process computes slice i (0 based) ...
+int shard_count = 0;                                // ... of N, 0 = not sharded
+std::string shard_dir = ".";                        // Where shard files are written and merged from (--shard-dir)
+bool use_merge = false;                             // Build the result from the shard files (--merge)
+bool use_factorized = false;                        // Cancel common prime factors in binary splitting (--factorized)
+long ntt_threshold = -1;                            // --ntt-threshold in limbs, -1 = default for the thread count
+std::string ntt_kernel = "auto";                    // --ntt-kernel: auto, scalar, avx2, avx512
+AsyncIoOptions io_options;                          // Output writes and reference reads (--io-depth, --io-direct, --io-backend)
+bool use_self_check = false;                        // Residue check big products and merge sums (--self-check)
+bool fingerprint_checks = true;                     // Debug term/sum checks by fingerprint (--term-check)
+bool build_index = false;                           // Index computed_pi.txt for digit searches (--index)
+std::string find_query;                             // --find: digits to look up, empty = compute as usual
+std::string find_file = "computed_pi.txt";          // Digits file --find searches (--find-in)
+bool run_tune = false;                              // Calibrate this host and save its profile (--tune)
+std::string profile_path;                           // Host profile file (--profile), empty = default per host
+bool use_profile = true;                            // Load the host profile at startup (--no-profile)
+HostProfile host_profile;                           // Tuned settings, threads 0 when none is loaded
+int chunk_size = 100;                               // Terms per dynamic Chudnovsky chunk (--chunk-size, host profile)
+
+// debug_level and console_mutex are declared in globals.hpp and defined in globals.cpp
 
 // Allow Cntrl C to stop each therad.
 void signal_handler(int signal) {
     if (signal == SIGINT) {
-        stop_requested.store(true);
+        if (pi_context != nullptr) pi_context->cancel();
         std::cerr << "\n[Interrupt] Ctrl+C received. Stopping calculation...\n";
     }
 }
 
 
-// Caculate the working precision for the chudnovsky algorithm to use.
-mpfr_prec_t get_chudnovsky_precision(int decimal_places, int buffer = 20000) 
-{
-    return static_cast<mpfr_prec_t>(ceil(decimal_places * 3.322 + buffer));
-}
-
-
 // Function to read Pi reference digits from file
 std::string read_pi_from_file(const std::string& filename, size_t digits)
 {
@@ -129,438 +166,98 @@ std::vector<std::string> load_reference_values(const std::string& filename)
     return values;
 }
 
-// Read power usage from the energy monitoring file
-long long read_energy_uj(const std::string& path) {
-    std::ifstream file(path);
-
-    if (!file.is_open()) {
-        std::cerr << "Error: Unable to open energy file at " << path << "\n";
-        std::cerr << "Hint: You may need to run the program with elevated permissions (e.g., using sudo)\n";
-        return -1;
-    }
-    else if (debug_level >= 4)
-    {
-        std::cerr << "The power usage file is open: " << path << "\n";
-    }
-
-    long long energy;
-    file >> energy;
-    return energy;
-}
-
-// Discover available RAPL power domains
-//std::vector<RaplDomain> discover_rapl_domains() {
-//    std::vector<RaplDomain> domains;
-//    const std::string base_path = "/sys/class/powercap/";
-//    try
-//    {
-//        for (const auto& entry : fs::recursive_directory_iterator(base_path))
-//        {
-//            if (entry.is_regular_file() && entry.path().filename() == "energy_uj")
-//            {
-//                std::ifstream test(entry.path());
-//                if (test.is_open()) {
-//                    RaplDomain domain;
-//                    domain.energy_path = entry.path();
-//                    domains.push_back(domain);
-//                    if (debug_level >= 3)
-//                    {
-//                        std::lock_guard<std::mutex> lock(console_mutex);
-//                        std::cerr << "[discover_rapl_domains] Usable domain: " << domain.energy_path << "\n";
-//                    }
-//                }
-//                else
-//                {
-//                    if (debug_level >= 2)
-//                    {
-//                        std::lock_guard<std::mutex> lock(console_mutex);
-//                        std::cerr << "[discover_rapl_domains] Skipped unreadable domain: " << entry.path() << "\n";
-//                    }
-//                }
-//            }
-//        }
-//    }
-//    catch (const std::exception& e)
-//    {
-//        std::lock_guard<std::mutex> lock(console_mutex);
-//        std::cerr << "[discover_rapl_domains] Filesystem error: " << e.what() << "\n";
-//    }
-//    if (domains.empty())
-//    {
-//        std::lock_guard<std::mutex> lock(console_mutex);
-//        std::cerr << "Warning: No readable power domains found. Power monitoring disabled.\n";
-//        std::cerr << "NOTE: Execute with sudo to allow read permission on monitoring domains.\n";
-//    }
-//
-//    return domains;
-//}
-
-// Discover available RAPL power domains
-std::vector<RaplDomain> discover_rapl_domains() {
-    std::vector<RaplDomain> domains;
-    const std::string base_path = "/sys/class/powercap/";
-    std::error_code ec;  // To catch filesystem errors without throwing
-    try
-    {
-        for (const auto& entry : fs::recursive_directory_iterator(base_path, fs::directory_options::skip_permission_denied, ec))
-        {
-            if (entry.is_regular_file(ec) && entry.path().filename() == "energy_uj")
-            {
-                std::ifstream test(entry.path());
-                if (test.is_open()) {
-                    RaplDomain domain;
-                    domain.energy_path = entry.path();
-                    domains.push_back(domain);
-                    if (debug_level >= 3)
-                    {
-                        std::lock_guard<std::mutex> lock(console_mutex);
-                        std::cerr << "[discover_rapl_domains] Usable domain: " << domain.energy_path << "\n";
-                    }
-                }
-                else
-                {
-                    if (debug_level >= 2)
-                    {
-                        std::lock_guard<std::mutex> lock(console_mutex);
-                        std::cerr << "[discover_rapl_domains] Skipped unreadable domain: " << entry.path() << "\n";
-                    }
-                }
-            }
-            else if (ec) {
-                if (debug_level >= 2)
-                {
-                    std::lock_guard<std::mutex> lock(console_mutex);
-                    std::cerr << "[discover_rapl_domains] Skipped unreadable or broken entry: " << entry.path() << " (Reason: " << ec.message() << ")\n";
-                }
-                ec.clear();  // Clear after handling
-            }
-        }
-    }
-    catch (const std::exception& e)
-    {
-        std::lock_guard<std::mutex> lock(console_mutex);
-        std::cerr << "[discover_rapl_domains] Filesystem exception: " << e.what() << "\n";
-    }
-
-    if (domains.empty())
-    {
-        std::lock_guard<std::mutex> lock(console_mutex);
-        std::cerr << "⚠️ Warning: No readable power domains found. Power monitoring disabled.\n";
-        std::cerr << "ℹ️  HINT: Try running with sudo if needed.\n";
-    }
-
-    return domains;
-}
-
-
-std::string format_domain_label(const std::string& name)
-{
-    if (name == "core") return   "CPU cores";
-    if (name == "uncore") return "CPU other";
-    if (name == "dram") return   "RAM";
-    // Skip "package-0" by returning an empty string
-    if (name == "package-0") return "";
-    return name;
-}
-
-void print_power_usage()
-{
-    std::lock_guard<std::mutex> lock(console_mutex);    // Lock console output.
-
-   if (rapl_domains.empty()) {
-        if (debug_level >= 2) {
-            std::cerr << "[Info] No energy data to report (power monitoring disabled).\n";
-        }
-        return; // Nothing to print
-    }
-
-    const int label_width = 15; // Total width to align labels
-
-    double total_power = 0;
-    std::cerr << "\n--- Power Usage by Domain ---\n";
-
-    for (const auto& domain : rapl_domains)
-    {
-        std::string label = format_domain_label(domain.name);
-        if (label.empty()) continue; // Skip "package-0"
-
-        int padding = label_width - static_cast<int>(label.length());
-        padding = std::max(0, padding); // Prevent negative spacing
-
-        std::cerr << label << std::string(padding, ' ') << ": "
-                  << std::fixed << std::setprecision(5)
-                  << domain.last_power_watts << " W\n";
-
-        total_power += domain.last_power_watts;
-    }
-
-    std::string total_label = "Total";
-    int total_padding = label_width - static_cast<int>(total_label.length());
-    total_padding = std::max(0, total_padding);
-
-    std::cerr << total_label << std::string(total_padding, ' ') << ": "
-              << std::fixed << std::setprecision(5)
-              << total_power << " W\n";
-}
-
-void monitor_power_usage()
-{
-    static bool domains_initialized = false;
-    static bool power_disabled      = false;
-
-    if (!domains_initialized) {
-        rapl_domains = discover_rapl_domains();
-        domains_initialized = true;
-
-        if (rapl_domains.empty()) {
-            power_disabled = true;
-        }
-    }
-
-    // Skip power monitoring if disabled
-    if (power_disabled) {
-        return;
-    }
-
-    // Proceed with power reading
-    std::vector<long long> prev_energies(rapl_domains.size());
-    std::vector<long long> curr_energies(rapl_domains.size());
-
-    for (size_t i = 0; i < rapl_domains.size(); ++i) {
-        prev_energies[i] = read_energy_uj(rapl_domains[i].energy_path);
-    }
-
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-
-    for (size_t i = 0; i < rapl_domains.size(); ++i) {
-        curr_energies[i] = read_energy_uj(rapl_domains[i].energy_path);
-        long long delta_uj = curr_energies[i] - prev_energies[i];
-        if (delta_uj < 0) delta_uj += (1LL << 32); // wraparound
-        rapl_domains[i].accumulated_energy_uj += delta_uj;
-        rapl_domains[i].last_power_watts = delta_uj / 1'000'000.0;
-    }
-}
-
-
-void print_accumulated_energy()
-{
-    if (rapl_domains.empty()) {
-        if (debug_level >= 2) {
-            std::cerr << "[Info] No energy data to report (power monitoring disabled).\n";
-        }
-        return; // Nothing to print
-    }
- 
-    const int energy_precision = 12;
-    const int label_width = 15; // Total width to right-align labels before ':'
-
-    double total_energy_wh = 0.0;
-    std::cerr << "\n--- Accumulated Energy ---\n";
-
-    for (const auto& domain : rapl_domains)
-    {
-        std::string label = format_domain_label(domain.name);
-        if (label.empty()) continue; // Skip "package-0"
-
-        double accumulated_energy_wh = domain.accumulated_energy_uj / 3'600'000'000.0;
-        int padding = label_width - static_cast<int>(label.length());
-        padding = std::max(0, padding); // Avoid negative padding
-
-        std::cerr << label << std::string(padding, ' ') << ": "
-                  << std::fixed << std::setprecision(energy_precision)
-                  << accumulated_energy_wh << " Wh\n";
-
-        total_energy_wh += accumulated_energy_wh;
-    }
-
-    std::string total_label = "Total";
-    int total_padding = label_width - static_cast<int>(total_label.length());
-    total_padding = std::max(0, total_padding);
-
-    std::cerr << total_label << std::string(total_padding, ' ') << ": "
-              << std::fixed << std::setprecision(energy_precision)
-              << total_energy_wh << " Wh\n";
-}
-
-// Multithreaded Chudnovsky calculation
-// Partition terms among threads
-// Launch threads and wait for them to finish
-// Combine partial results into final sum
-
-void calculate_pi_multithreaded(
-    int max_terms,
-    mpfr_t pi_approx,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
+// Write one metrics record from a system sample and the progress counters
+void export_metrics(const SystemSample& sample, bool finished)
 {
-    if (debug_level >=2)
-    {
-       std::cerr << "Using " << thread_count << " worker threads for Chudnovsky calculation.\n";
-    }
-
-    iterations.store(max_terms, std::memory_order_relaxed);
-    iteration_counter.store(0, std::memory_order_relaxed);
-
-    // Precision estimate
-    //  mpfr_prec_t working_prec = get_chudnovsky_precision(decimal_places);
-    working_prec = get_chudnovsky_precision(decimal_places);
-    if (debug_level >=2)
-    {
-        std::cout << "working precission= " << working_prec << " \n";
-    }
-
-    // Allocate space for thread results
-    mpfr_t* shared_results = new mpfr_t[thread_count];
-    for (int i = 0; i < thread_count; ++i)
-    {
-        mpfr_init2(shared_results[i], working_prec);
-        mpfr_set_zero(shared_results[i], 1); // Positive zero
-    }
-
-    // Divide work
-    int terms_per_thread = max_terms / thread_count;
-    int leftover_terms = max_terms % thread_count;
-
-    std::vector<std::thread> threads;
-    int current_term = 0;
-
-    if(debug_level >= 2)
-    {
-        std::cout << "max_terms = " << max_terms << "\n";
-    }
-
-    for (int i = 0; i < thread_count; ++i)
-    {
-        int extra = (i < leftover_terms) ? 1 : 0;
-        int start = current_term;
-        int end = start + terms_per_thread + extra;
-
-        if (debug_level >= 2)
-        {
-            std::lock_guard<std::mutex> lock(console_mutex);
-            std::cout << "[Thread " << i << "] k from " << start << " to " << (end - 1) << "\n";
-        }
-
-        threads.emplace_back(ChudnovskyTermCalculator::chudnovsky_worker, i, start, end, shared_results, working_prec, debug_level, reference_terms, reference_sums);
-        current_term = end;
-    }
-
-    for (auto& t : threads)
-    {
-        t.join();
-    }
-
-    if (stop_requested.load())
-    {
-        std::cerr << "Calculation aborted by user.\n";
-        delete[] shared_results;
-        return; // Skip output and cleanup safely
-    }
-
-    // Display the shared_results
-    if (debug_level >=3 )
-    {
-        for (int i = 0; i < thread_count; ++i)
-        {
-            std::cerr << "[Main] shared_results[" << i << "] = ";
-            mpfr_out_str(stderr, 10, 100, shared_results[i], MPFR_RNDN);
-            std::cerr << "\n";
-        }
-    }
-
-//  Sum results
-    mpfr_t total_sum;
-    mpfr_init2(total_sum, working_prec);
-    mpfr_set_zero(total_sum, 1);
-
-    for (int i = 0; i < thread_count; ++i)
-    {
-        if (debug_level >= 3)
-        {
-            std::cerr << "[Main] shared_results[" << i << "] = ";
-            mpfr_out_str(stderr, 10, 80, shared_results[i], MPFR_RNDN);
-            std::cerr << "\n";
-        }
-
-        mpfr_add(total_sum, total_sum, shared_results[i], MPFR_RNDN);
-
-        if (debug_level >= 3)
-        {
-            std::cerr << "Accumulated total after thread[" << i << "] = ";
-            mpfr_out_str(stderr, 10, 80, total_sum, MPFR_RNDN);
-            std::cerr << "\n";
-        }
-
-        mpfr_clear(shared_results[i]);
-    }
-    delete[] shared_results;
-
-    // === CHUDNOVSKY CONSTANT C = 426880 * sqrt(10005) ===
-    mpfr_t C, sqrt_10005;
-    mpfr_init2(C, working_prec);
-    mpfr_init2(sqrt_10005, working_prec);
-
-    mpfr_sqrt_ui(sqrt_10005, 10005, MPFR_RNDN);
-    mpfr_mul_ui(C, sqrt_10005, 426880, MPFR_RNDN);
-
-    // === Final division: pi = C / sum ===
-    mpfr_div(pi_approx, C, total_sum, MPFR_RNDN);
-
-    mpfr_clear(total_sum);
-    mpfr_clear(C);
-    mpfr_clear(sqrt_10005);
-
-    // Optional verbose final output
-    if (debug_level >= 3)
-    {
-        mpfr_printf("Final computed pi = %.*Rf\n", decimal_places, pi_approx);
-    }
-    else
-    {
-        mpfr_printf("Final computed pi output to file name computed_pi.txt \n");
-    }
+    if (!metrics_exporter.enabled()) return;
+
+    MetricsSnapshot m;
+    m.method = calculation_method;
+    m.phase = trace_current_phase();
+    m.decimal_places = decimal_places;
+    m.iterations = pi_context ? pi_context->progress_total() : 0;
+    m.iteration_counter = pi_context ? pi_context->progress_done() : 0;
+    m.elapsed_seconds = trace_now_us() / 1e6;
+    m.rss_kb = get_process_rss_kb();
+    m.mem_available_kb = sample.mem_available_kb;
+    m.max_temperature_c = sample.max_temperature_c;
+    m.energy_joules = total_energy_joules();
+    m.power_watts = total_power_watts();
+    m.finished = finished;
+    metrics_exporter.write(m);
 }
 
 // Function to monitor system in a separate thread
 void monitor_system()
 {
-    static auto last_time = std::chrono::steady_clock::now();
+    trace_set_thread_name("monitor");
+
+#ifdef __linux__
+    // Run the sampler at a lower priority than the worker threads
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+
+    system_sampler.discover();
+    const auto interval = std::chrono::duration<double>(monitor_interval_seconds);
 
     while (keep_monitoring)
     {
-        // Sleep first so early values don’t confuse deltas
-        for (int i = 0; i < 10 && keep_monitoring; ++i)
+        // Sleep first so early values don’t confuse deltas. stop_monitoring() wakes us early.
         {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::unique_lock<std::mutex> lock(monitor_mutex);
+            monitor_cv.wait_for(lock, interval, [] { return !keep_monitoring; });
         }
 
-        auto current_time = std::chrono::steady_clock::now();
-        last_time = current_time;
+        const SystemSample& sample = system_sampler.take_sample();
 
-        // Show power usage for each RAPL domain
-        if (debug_level >= 2)
+        // Sample the RAPL counters and show power usage for each domain
+        if (energy_monitoring_enabled())
         {
-           // When I updated my HDD to SSD the power monitor stuff stopped working.
-           // ChatGPT and I tried various different things but the rabbit hole kept getting deeper.
-           // To continue uncomment the follwoing two lines and start debugging :) (--debug 2 and above)
-           //monitor_power_usage(); //<TODO>
-           //print_power_usage();  // <TODO>
+            monitor_power_usage(trace_current_phase());
+            if (debug_level >= 2)
+            {
+                print_power_usage();
+            }
         }
 
+        export_metrics(sample, false);
+
         // Show CPU Core Temperatures
         if (debug_level >= 1)
         {
-            std::cout << "--- Checking CPU temperature ---\n";
-            std::system("sensors | grep 'Core' | awk '{print $1, $2, $3}'");
+            const auto& labels = system_sampler.temperature_labels();
+            bool have_core_labels = std::any_of(labels.begin(), labels.end(),
+                [](const std::string& label) { return label.find("Core") != std::string::npos; });
+
+            if (sample.temperature_count > 0)
+            {
+                std::cout << "--- Checking CPU temperature ---\n";
+                for (int i = 0; i < sample.temperature_count; ++i)
+                {
+                    // Prefer per core readings when the sensor labels them, like 'sensors | grep Core'
+                    if (have_core_labels && labels[i].find("Core") == std::string::npos) continue;
+                    std::cout << labels[i] << ": +" << std::fixed << std::setprecision(1)
+                              << sample.temperatures_c[i] << "°C\n";
+                }
+            }
+            else
+            {
+                std::cout << "--- CPU temperature unavailable (no readable /sys/class/hwmon sensors) ---\n";
+            }
+
+            if (sample.avg_frequency_mhz > 0)
+            {
+                std::cout << "--- CPU Frequency ---\n " << std::fixed << std::setprecision(0)
+                          << sample.avg_frequency_mhz << " MHz average, " << sample.max_frequency_mhz << " MHz max\n";
+            }
         }
 
         // Show Available Free Memory
         if (debug_level >= 1)
         {
-            long free_mem_kb = get_free_memory_kb();
-            if (free_mem_kb != -1)
+            if (sample.mem_available_kb != -1)
             {
-                std::cout << "--- Available Memory ---\n " << free_mem_kb / 1024 << " MB\n";
+                std::cout << "--- Available Memory ---\n " << sample.mem_available_kb / 1024 << " MB\n";
             }
             else
             {
@@ -568,6 +265,8 @@ void monitor_system()
             }
         }
         // Show Calculation Progress
+        long long iterations = pi_context ? pi_context->progress_total() : 0;
+        long long iteration_counter = pi_context ? pi_context->progress_done() : 0;
         if (iterations != 0)
         {
             double progress = static_cast<double>(iteration_counter) / static_cast<double>(iterations) * 100;
@@ -579,11 +278,33 @@ void monitor_system()
             std::cout << "--- Progress Initialization not complete yet (0%) ---\n";
         }
     }
-//    <TODO> Power monitoring disabled due to glitches with detecting power domains automatically
-//    if (debug_level >=2)
-//    {
-//        print_accumulated_energy();
-//    }
+}
+
+// Ask the monitoring thread to take its final sample and exit without waiting out the interval
+void stop_monitoring()
+{
+    {
+        std::lock_guard<std::mutex> lock(monitor_mutex);
+        keep_monitoring = false;
+    }
+    monitor_cv.notify_all();
+}
+
+// Peak temperature, lowest free memory and average frequency seen by the monitoring thread
+void print_system_summary()
+{
+    float peak_temperature_c = 0.0f;
+    float avg_frequency_mhz = 0.0f;
+    long min_mem_available_kb = -1;
+    system_sampler.summarize(peak_temperature_c, min_mem_available_kb, avg_frequency_mhz);
+
+    std::cout << "\n--- System Summary (" << system_sampler.sample_count() << " samples) ---\n";
+    if (peak_temperature_c > 0)
+        std::cout << "Peak temperature     : " << std::fixed << std::setprecision(1) << peak_temperature_c << " °C\n";
+    if (avg_frequency_mhz > 0)
+        std::cout << "Average CPU frequency: " << std::fixed << std::setprecision(0) << avg_frequency_mhz << " MHz\n";
+    if (min_mem_available_kb >= 0)
+        std::cout << "Lowest free memory   : " << min_mem_available_kb / 1024 << " MB\n";
 }
 
 // Function to output verification result
@@ -606,9 +327,61 @@ void print_verification_result_unknown(off_t requested, off_t available)
               << available << ")\033[0m" << std::endl;
 }
 
+// Rough peak memory of a run in bytes: working values at full precision plus the decimal
+// output string. Each Chudnovsky worker holds its scratchpad factorials, term and local sum.
+long long estimate_peak_memory_bytes(int workers)
+{
+    long long output_bytes = decimal_places * 3;            // mpfr string, std::string copy, file buffer
+    if (calculation_method == "binary_splitting")
+    {
+        // P, Q and T of the top merge are each about the working precision, plus every worker's slice
+        long long value_bytes = static_cast<long long>(get_chudnovsky_precision(decimal_places)) / 8;
+        return value_bytes * (6LL + 3LL * workers) + output_bytes;
+    }
+    if (calculation_method == "chudnovsky")
+    {
+        long long value_bytes = static_cast<long long>(get_chudnovsky_precision(decimal_places)) / 8;
+        return value_bytes * (20LL * workers + 8) + output_bytes;
+    }
+    long long value_bytes = (decimal_places + 5) * 4 / 8;  // Gauss-Legendre precision in bits / 8
+    return value_bytes * 10 + output_bytes;
+}
+
+// Load the host profile unless it was tuned on different hardware
+void load_profile()
+{
+    std::string path = profile_path.empty() ? default_profile_path() : profile_path;
+    HostProfile loaded;
+    if (!load_host_profile(path, loaded))
+    {
+        if (!profile_path.empty())
+            std::cerr << "⚠️ Warning: Could not load host profile " << path << ", using the built-in defaults.\n";
+        else if (debug_level >= 1)
+            std::cerr << "[Info] No host profile at " << path << " (calculate_pi --tune writes one)\n";
+        return;
+    }
+
+    std::string reason;
+    if (!host_profile_matches(loaded, reason))
+    {
+        std::cerr << "⚠️ Warning: Ignoring host profile " << path << ": " << reason << ". Run --tune again.\n";
+        return;
+    }
+    host_profile = loaded;
+    if (debug_level >= 1)
+    {
+        std::cerr << "[Info] Host profile " << path << ": " << host_profile.threads << " threads, leaf size "
+                  << host_profile.leaf_size << ", chunk size " << host_profile.chunk_size << "\n";
+    }
+}
+
+
 bool parse_command_line(int argc, char* argv[])
 {
     bool decimal_places_set = false;
+    bool method_set = false;
+    bool leaf_size_set = false;
+    bool chunk_size_set = false;
     int user_thread_request = -1;
 
 
@@ -624,10 +397,45 @@ bool parse_command_line(int argc, char* argv[])
                       << "Options:\n"
                       << "  -f, --file <filename>        Specify reference Pi file (default ./Pi-Dec-Chudnovsky_01.txt) \n"
                       << "  -d, --debug <1|2|3>          Set debug level (default: 0)\n"
-                      << "  -m, --method <name>          Choose method: 'gauss_legendre' (default), 'chudnovsky'\n"
+                      << "  -m, --method <name>          Choose method: 'gauss_legendre', 'chudnovsky', 'binary_splitting'\n"
+                      << "                               (default: the host profile's fastest for the size, else gauss_legendre)\n"
                       << "      --threads <count>        Number of threads to use (valid only for Chudnovsky) default is max -1\n"
+                      << "      --term-check <mode>      -d 2/3 reference checks: 'fingerprint' (default) or 'string'\n"
                       << "  -h, --help                   Show this help message\n"
-                      << "      --dynamic                Use dynamic work allocation with Chudnovsky multi threaded\n";
+                      << "      --dynamic                Use dynamic work allocation with Chudnovsky multi threaded\n"
+                      << "      --chunk-size <terms>     Terms per --dynamic chunk (default 100 or the host profile's)\n"
+                      << "      --trace <file>           Write a Chrome trace-event JSON file of the computation phases\n"
+                      << "      --perf-counters          Report hardware performance counters (cycles, IPC, misses) per phase\n"
+                      << "      --monitor-interval <sec> Seconds between system monitoring samples (default 10)\n"
+                      << "      --energy                 Report RAPL energy per phase and per million digits (also on with -d 2)\n"
+                      << "      --metrics-file <file>    Write progress metrics every monitoring interval\n"
+                      << "      --metrics-format <fmt>   'prom' (Prometheus textfile, default) or 'json' (JSON lines)\n"
+                      << "      --pin                    Pin each Chudnovsky worker thread to its own CPU\n"
+                      << "      --skip-smt               Pin to one hardware thread per core (implies --pin)\n"
+                      << "      --numa                   Keep worker memory on the local NUMA node, merge per node (implies --pin)\n"
+                      << "      --serve <socket>         Run as a daemon serving digit ranges over a Unix socket\n"
+                      << "      --serve-max <digits>     Largest computation a client request may trigger (default 100 x decimal_places)\n"
+                      << "      --cache-dir <dir>        Reuse and extend results kept in dir (binary_splitting resumes from the saved terms)\n"
+                      << "      --batch <file>           Compute once for every target in file (<N> or <first>-<last> [output] per line)\n"
+                      << "      --base <16|2|raw|N>      Output pi in another base (2..62) or as raw fraction bytes\n"
+                      << "      --constant <name>        pi (default), e, sqrt2, log2, zeta3 or catalan\n"
+                      << "      --shard <i>/<N>          binary_splitting: compute slice i (0..N-1) of the terms into a shard file\n"
+                      << "      --shard-dir <dir>        Directory for shard files (default .)\n"
+                      << "      --merge                  Combine the shard files in --shard-dir into the result\n"
+                      << "      --leaf-size <terms>      Terms per binary_splitting leaf, combined in 128-bit integers (default 32)\n"
+                      << "      --factorized             binary_splitting: cancel prime factors P and Q share at each merge\n"
+                      << "      --ntt-threshold <limbs>  NTT multiply for binary_splitting products this large (0 = off)\n"
+                      << "      --ntt-kernel <name>      auto (default, from cpuid), scalar, avx2 or avx512\n"
+                      << "      --self-check             Check large binary_splitting products and sums by residues, redo failures\n"
+                      << "      --io-depth <n>           File reads and writes in flight at most (default 8)\n"
+                      << "      --io-direct              Write output files with O_DIRECT, bypassing the page cache\n"
+                      << "      --io-backend <name>      auto (default, io_uring where available), uring or threads\n"
+                      << "      --index                  Build a digit search index next to computed_pi.txt after output\n"
+                      << "      --find <digits>          Print where digits first occur in computed_pi.txt (no computation)\n"
+                      << "      --find-in <file>         Digits file for --find (default computed_pi.txt)\n"
+                      << "      --tune                   Time short runs on this host and save its profile (sizes up to decimal_places, default 1M)\n"
+                      << "      --profile <file>         Host profile to load or write (default ~/.config/calculate_pi/<host>.profile)\n"
+                      << "      --no-profile             Ignore the host profile and use the built-in defaults\n";
             return false; // Return false to prevent program from continuing
         }
 
@@ -673,7 +481,9 @@ bool parse_command_line(int argc, char* argv[])
             if (i + 1 < argc)
             {
                 calculation_method = argv[++i];
-                if (calculation_method != "gauss_legendre" && calculation_method != "chudnovsky")
+                method_set = true;
+                if (calculation_method != "gauss_legendre" && calculation_method != "chudnovsky" &&
+                    calculation_method != "binary_splitting")
                 {
                     std::cerr << "Error: Unknown method: " << calculation_method << "\n";
                     return false;
@@ -699,22 +509,502 @@ bool parse_command_line(int argc, char* argv[])
                 }
                 catch (const std::exception& e)
                 {
-                    std::cerr << "Invalid thread count: " << e.what() << "\n";
+                    std::cerr << "Invalid thread count: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --threads requires a number.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--dynamic") 
+        {
+            use_dynamic = true;
+        }
+        else if (arg == "--chunk-size")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    chunk_size = std::stoi(argv[++i]);
+                    if (chunk_size < 1)
+                        throw std::invalid_argument("Chunk size must be at least 1 term.");
+                    chunk_size_set = true;
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid chunk size: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --chunk-size requires a number.\n";
+                return false;
+            }
+        }
+
+        // Chrome trace output
+        else if (arg == "--trace")
+        {
+            if (i + 1 < argc)
+            {
+                trace_filename = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --trace requires a filename.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--perf-counters")
+        {
+            use_perf_counters = true;
+        }
+
+        else if (arg == "--energy")
+        {
+            use_energy = true;
+        }
+
+        // Thread placement
+        else if (arg == "--pin")
+        {
+            use_pinning = true;
+        }
+
+        else if (arg == "--skip-smt")
+        {
+            use_pinning = true;
+            skip_smt = true;
+        }
+
+        else if (arg == "--numa")
+        {
+            use_pinning = true;
+            use_numa = true;
+        }
+
+        // Machine-readable metrics
+        else if (arg == "--metrics-file")
+        {
+            if (i + 1 < argc)
+            {
+                metrics_filename = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --metrics-file requires a filename.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--metrics-format")
+        {
+            if (i + 1 < argc)
+            {
+                metrics_format = argv[++i];
+                if (metrics_format != "prom" && metrics_format != "json")
+                {
+                    std::cerr << "Error: Unknown metrics format: " << metrics_format << " (use prom or json)\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --metrics-format requires prom or json.\n";
+                return false;
+            }
+        }
+
+        // Daemon mode
+        else if (arg == "--serve")
+        {
+            if (i + 1 < argc)
+            {
+                serve_socket = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --serve requires a socket path.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--serve-max")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    serve_max_digits = std::stoll(argv[++i]);
+                    if (serve_max_digits <= 0)
+                        throw std::invalid_argument("Digit limit must be positive.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid --serve-max: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --serve-max requires a number of digits.\n";
+                return false;
+            }
+        }
+
+        // Batch of targets from one computation
+        else if (arg == "--batch")
+        {
+            if (i + 1 < argc)
+            {
+                batch_filename = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --batch requires a filename.\n";
+                return false;
+            }
+        }
+
+        // Constant to compute
+        else if (arg == "--constant")
+        {
+            if (i + 1 < argc)
+            {
+                constant_name = argv[++i];
+                if (!pi_constant_from_name(constant_name, constant))
+                {
+                    std::cerr << "Error: Unknown constant: " << constant_name << " (use pi, e, sqrt2, log2, zeta3 or catalan)\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --constant requires a name.\n";
+                return false;
+            }
+        }
+
+        // Output base
+        else if (arg == "--base")
+        {
+            if (i + 1 < argc)
+            {
+                std::string base = argv[++i];
+                try
+                {
+                    output_base = (base == "raw") ? 256 : std::stoi(base);
+                    if (output_base != 256 && (output_base < 2 || output_base > 62))
+                        throw std::invalid_argument("Base must be 2..62 or raw.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid base: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --base requires 2..62 or raw.\n";
+                return false;
+            }
+        }
+
+        // Sharded computation
+        else if (arg == "--shard")
+        {
+            if (i + 1 < argc)
+            {
+                std::string shard = argv[++i];
+                size_t slash = shard.find('/');
+                try
+                {
+                    if (slash == std::string::npos)
+                        throw std::invalid_argument("expected <i>/<N>.");
+                    shard_index = std::stoi(shard.substr(0, slash));
+                    shard_count = std::stoi(shard.substr(slash + 1));
+                    if (shard_count < 1 || shard_index < 0 || shard_index >= shard_count)
+                        throw std::invalid_argument("need 0 <= i < N.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid shard " << shard << ": " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --shard requires <i>/<N>.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--shard-dir")
+        {
+            if (i + 1 < argc)
+            {
+                shard_dir = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --shard-dir requires a directory.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--merge")
+        {
+            use_merge = true;
+        }
+
+        // Binary splitting leaves
+        else if (arg == "--leaf-size")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    leaf_size = std::stoi(argv[++i]);
+                    if (leaf_size < 1)
+                        throw std::invalid_argument("Leaf size must be at least 1 term.");
+                    leaf_size_set = true;
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid leaf size: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --leaf-size requires a number of terms.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--factorized")
+        {
+            use_factorized = true;
+        }
+
+        // NTT multiplication
+        else if (arg == "--ntt-threshold")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    ntt_threshold = std::stol(argv[++i]);
+                    if (ntt_threshold < 0)
+                        throw std::invalid_argument("Threshold must be 0 or more limbs.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid NTT threshold: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --ntt-threshold requires a number of limbs.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--ntt-kernel")
+        {
+            if (i + 1 < argc)
+            {
+                ntt_kernel = argv[++i];
+                if (ntt_kernel != "auto" && ntt_kernel != "scalar" && ntt_kernel != "avx2" && ntt_kernel != "avx512")
+                {
+                    std::cerr << "Error: Unknown NTT kernel: " << ntt_kernel << " (auto, scalar, avx2 or avx512)\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --ntt-kernel requires a name.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--self-check")
+        {
+            use_self_check = true;
+        }
+
+        // Asynchronous file I/O
+        else if (arg == "--io-depth")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    io_options.depth = std::stoi(argv[++i]);
+                    if (io_options.depth < 1 || io_options.depth > 256)
+                        throw std::invalid_argument("Depth must be 1 to 256.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid I/O depth: " << e.what() << "\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --io-depth requires a number.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--io-direct")
+        {
+            io_options.direct = true;
+        }
+
+        else if (arg == "--io-backend")
+        {
+            if (i + 1 < argc)
+            {
+                io_options.backend = argv[++i];
+                if (io_options.backend != "auto" && io_options.backend != "uring" && io_options.backend != "threads")
+                {
+                    std::cerr << "Error: Unknown I/O backend: " << io_options.backend << " (auto, uring or threads)\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --io-backend requires a name.\n";
+                return false;
+            }
+        }
+
+        // Reference checks of terms and sums at -d 2/3
+        else if (arg == "--term-check")
+        {
+            if (i + 1 < argc)
+            {
+                std::string mode = argv[++i];
+                if (mode != "fingerprint" && mode != "string")
+                {
+                    std::cerr << "Error: Unknown term check: " << mode << " (fingerprint or string)\n";
+                    return false;
+                }
+                fingerprint_checks = (mode == "fingerprint");
+            }
+            else
+            {
+                std::cerr << "Error: --term-check requires 'fingerprint' or 'string'.\n";
+                return false;
+            }
+        }
+
+        // Digit search
+        else if (arg == "--index")
+        {
+            build_index = true;
+        }
+
+        else if (arg == "--find")
+        {
+            if (i + 1 < argc)
+            {
+                find_query = argv[++i];
+                if (find_query.empty() || find_query.find_first_not_of("0123456789") != std::string::npos)
+                {
+                    std::cerr << "Error: --find takes a string of decimal digits.\n";
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Error: --find requires digits to look for.\n";
+                return false;
+            }
+        }
+
+        else if (arg == "--find-in")
+        {
+            if (i + 1 < argc)
+            {
+                find_file = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --find-in requires a file name.\n";
+                return false;
+            }
+        }
+
+        // Host profile
+        else if (arg == "--tune")
+        {
+            run_tune = true;
+        }
+        else if (arg == "--profile")
+        {
+            if (i + 1 < argc)
+            {
+                profile_path = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --profile requires a file name.\n";
+                return false;
+            }
+        }
+        else if (arg == "--no-profile")
+        {
+            use_profile = false;
+        }
+
+        // Result cache
+        else if (arg == "--cache-dir")
+        {
+            if (i + 1 < argc)
+            {
+                cache_dir = argv[++i];
+            }
+            else
+            {
+                std::cerr << "Error: --cache-dir requires a directory.\n";
+                return false;
+            }
+        }
+
+        // Monitoring interval
+        else if (arg == "--monitor-interval")
+        {
+            if (i + 1 < argc)
+            {
+                try
+                {
+                    monitor_interval_seconds = std::stod(argv[++i]);
+                    if (monitor_interval_seconds < 0.1)
+                        throw std::invalid_argument("Interval must be at least 0.1 seconds.");
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Invalid monitor interval: " << e.what() << "\n";
                     return false;
                 }
             }
             else
             {
-                std::cerr << "Error: --threads requires a number.\n";
+                std::cerr << "Error: --monitor-interval requires a number of seconds.\n";
                 return false;
             }
         }
 
-        else if (arg == "--dynamic") 
-        {
-            use_dynamic = true;
-        }
-
         // Unrecognized switch
         else if (arg[0] == '-')
         {
@@ -745,6 +1035,97 @@ bool parse_command_line(int argc, char* argv[])
         }
     }
 
+    // A search answers from the files already there and computes nothing
+    if (!find_query.empty())
+    {
+        return true;
+    }
+
+    // Calibration times its own runs, up to the decimal places given
+    if (run_tune)
+    {
+        if (!decimal_places_set) decimal_places = 1000000;
+        return true;
+    }
+
+    // Settings tuned for this host, wherever the command line keeps the default
+    if (use_profile)
+    {
+        load_profile();
+        if (host_profile.threads > 0)
+        {
+            if (!leaf_size_set && host_profile.leaf_size > 0) leaf_size = host_profile.leaf_size;
+            if (ntt_threshold < 0 && host_profile.ntt_threshold >= 0) ntt_threshold = host_profile.ntt_threshold;
+            if (!chunk_size_set && host_profile.chunk_size > 0) chunk_size = host_profile.chunk_size;
+        }
+    }
+
+    if (build_index && (!batch_filename.empty() || !serve_socket.empty() || output_base != 10 ||
+                        constant != PiConstant::Pi || shard_count > 0))
+    {
+        std::cerr << "Error: --index works with single pi runs written to computed_pi.txt.\n";
+        return false;
+    }
+
+    if (output_base != 10 && (!batch_filename.empty() || !serve_socket.empty()))
+    {
+        std::cerr << "Error: --base works with single runs only, not --batch or --serve.\n";
+        return false;
+    }
+
+    // Constants other than pi are only summed by the hypergeometric binary splitting engine
+    if (constant != PiConstant::Pi)
+    {
+        if (method_set && calculation_method != "binary_splitting")
+        {
+            std::cerr << "Error: --constant " << constant_name << " is computed by binary_splitting only.\n";
+            return false;
+        }
+        if (!batch_filename.empty() || !serve_socket.empty() || !cache_dir.empty())
+        {
+            std::cerr << "Error: --batch, --serve and --cache-dir work with pi only.\n";
+            return false;
+        }
+        calculation_method = "binary_splitting";
+    }
+
+    // Shards and their merge are binary splitting states of pi
+    if (shard_count > 0 || use_merge)
+    {
+        if (shard_count > 0 && use_merge)
+        {
+            std::cerr << "Error: --shard and --merge are separate runs.\n";
+            return false;
+        }
+        if (method_set && calculation_method != "binary_splitting")
+        {
+            std::cerr << "Error: --shard and --merge need -m binary_splitting.\n";
+            return false;
+        }
+        if (constant != PiConstant::Pi || !serve_socket.empty() || !cache_dir.empty())
+        {
+            std::cerr << "Error: --shard and --merge work with pi only, without --serve or --cache-dir.\n";
+            return false;
+        }
+        if (shard_count > 0 && (!batch_filename.empty() || output_base != 10))
+        {
+            std::cerr << "Error: A shard writes no digits, so --batch and --base do not apply.\n";
+            return false;
+        }
+        calculation_method = "binary_splitting";
+    }
+
+    // In batch mode the largest target sets the size of the computation
+    if (!batch_filename.empty())
+    {
+        if (!load_batch_targets(batch_filename, batch_targets))
+        {
+            return false;
+        }
+        decimal_places = std::max(decimal_places_set ? decimal_places : 0, batch_max_decimal_places(batch_targets));
+        decimal_places_set = true;
+    }
+
     if (!decimal_places_set)
     {
         std::cerr << "Error: Decimal places argument is required.\n";
@@ -757,9 +1138,34 @@ bool parse_command_line(int argc, char* argv[])
         calculation_method = "gauss_legendre";
     }
 
-    if (calculation_method == "chudnovsky")
+    // The residue checks sit in the binary splitting arithmetic, so without -m they choose it
+    if (use_self_check)
+    {
+        if (method_set && calculation_method != "binary_splitting")
+        {
+            std::cerr << "Error: --self-check checks binary_splitting only, not " << calculation_method << ".\n";
+            return false;
+        }
+        calculation_method = "binary_splitting";
+    }
+
+    // Without -m the host profile picks the method that was fastest at this size
+    if (!method_set && !use_self_check && constant == PiConstant::Pi && shard_count == 0 && !use_merge)
+    {
+        std::string tuned_method = host_profile_method(host_profile, decimal_places);
+        if (!tuned_method.empty()) calculation_method = tuned_method;
+    }
+
+    if (calculation_method == "chudnovsky" || calculation_method == "binary_splitting")
     {
-        int max_threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+        // CPUs we may really use: the cgroup CPU quota and cpuset, not the host's core count
+        int max_threads = std::max(1, container_limits().effective_cpus - 1);
+
+        if (use_pinning && placement_configure(skip_smt, use_numa) && skip_smt)
+        {
+            // One worker per physical core, still leaving one for the main and monitoring threads
+            max_threads = std::max(1, placement_cpu_count() - 1);
+        }
 
         if (user_thread_request != -1)
         {
@@ -773,9 +1179,23 @@ bool parse_command_line(int argc, char* argv[])
         }
         else
         {
-            // No --threads given, use default
+            // No --threads given, use the tuned count or the default
             thread_count = max_threads;
-            std::cerr << "[Info] Using " << thread_count << " threads by default (available CPUs - 1)\n";
+            if (host_profile.threads > 0) thread_count = std::min(max_threads, host_profile.threads);
+
+            // Fewer workers when their memory would not fit in what is left (container limit aware)
+            long long available = container_available_memory_bytes();
+            while (thread_count > 1 && available > 0 && estimate_peak_memory_bytes(thread_count) > available)
+            {
+                --thread_count;
+            }
+            if (thread_count < max_threads)
+            {
+                std::cerr << "[Info] Reduced to " << thread_count << " threads to fit in "
+                          << available / (1024 * 1024) << " MB of available memory\n";
+            }
+            std::cerr << "[Info] Using " << thread_count << " threads by default ("
+                      << (host_profile.threads > 0 ? "host profile" : "available CPUs - 1") << ")\n";
         }
     }
     else
@@ -857,211 +1277,333 @@ std::size_t find_divergence_location(const std::string& ref, const std::string&
 }
 
 // Function to compare computed π with reference π from a file
-void verify_pi_from_file(const std::string& computed_pi_str)
+void verify_pi_from_file(const std::string& computed_pi_str, off_t offset = 0, const std::string& label = "Pi verification")
 {
+    TraceSpan verification_span("verification");
+
+    // Decimal places the text reaches: offset counts "3." as two characters
+    off_t length = static_cast<off_t>(computed_pi_str.size());
+    off_t last_place = offset + length - 2;
+
     //Check reference file size BEFORE opening and reading
     off_t file_size = get_actual_file_size(reference_filename);
 
     if (file_size == -1)
     {
         std::cerr << "Error: Unable to get size of reference file: " << reference_filename << std::endl;
-        print_verification_result_unknown(decimal_places, 0);
+        print_verification_result_unknown(last_place, 0);
         return;
     }
 
     // Calculate available decimal places
     off_t available_decimal_places = file_size - 2; // Minus 2 for "3."
 
-    if (decimal_places > available_decimal_places)
+    if (last_place > available_decimal_places)
     {
-        print_verification_result_unknown(decimal_places, available_decimal_places);
+        print_verification_result_unknown(last_place, available_decimal_places);
         return; // Skip validation as file is too short
     }
 
-    // Proceed as usual
-    std::ifstream reference_file(reference_filename);
-    if (!reference_file)
+    // Read only the characters the computed text covers, in blocks read concurrently
+    std::string reference_pi_str(length, '\0');
+    if (!async_read_file(reference_filename, offset, &reference_pi_str[0], length, io_options))
     {
-        std::cerr << "Error: Could not open reference file." << std::endl;
+        std::cerr << "Error: Could not read reference file." << std::endl;
         return;
     }
 
-    // Read only the required number of characters from the reference file
-    std::string reference_pi_str;
-    reference_pi_str.reserve(decimal_places + 2); // Reserve space for "3." and the decimal places
-    char ch;
-    for (int i = 0; i < decimal_places + 2; ++i) // Read "3." and decimal_places digits
+    if (debug_level >= 2)
     {
-        if (reference_file.get(ch))
-        {
-            reference_pi_str += ch;
-        }
-        else
-        {
-            std::cerr << "Error: Reference file is shorter than expected." << std::endl;
-            return;
-        }
+        std::cout << "Reference Pi: " << reference_pi_str << std::endl;
+        std::cout << "Computed Pi:  " << computed_pi_str << std::endl;
+    }
+
+    // Now compare the values
+    if (computed_pi_str == reference_pi_str)
+    {
+        print_verification_result(true, label);
     }
+    else
+    {
+        print_verification_result(false, label);
+    }
+}
 
-    // Truncate computed Pi to decimal_places + 2 (+2 is for "3.")
-    std::string computed_pi_trimmed = computed_pi_str.substr(0, decimal_places + 2); // Keep "3." + requested digits
+// Write each --batch target from the full result and verify it on its own
+void write_batch_outputs(const char* computed_digits)
+{
+    // Every file is written in the background while the targets are verified
+    std::vector<AsyncFileWrite> outputs(batch_targets.size());
+    for (size_t i = 0; i < batch_targets.size(); ++i)
+    {
+        const BatchTarget& target = batch_targets[i];
 
-    // Truncate the reference Pi to the same length
-    std::string reference_pi_trimmed = reference_pi_str.substr(0, decimal_places + 2);
+        // A prefix keeps "3."; decimal place n is at offset n + 1
+        off_t offset = (target.first == 0) ? 0 : target.first + 1;
+        size_t length = (target.first == 0) ? target.last + 2 : target.last - target.first + 1;
+        outputs[i].start(target.output, computed_digits + offset, length, "\n", io_options);
 
-    if (debug_level >= 2)
+        verify_pi_from_file(std::string(computed_digits + offset, length), offset, "Pi verification " + target.output);
+    }
+
+    TraceSpan write_span("file write");
+    for (size_t i = 0; i < batch_targets.size(); ++i)
+    {
+        if (!outputs[i].wait()) std::cerr << "Error: Could not write " << batch_targets[i].output << std::endl;
+    }
+}
+
+// The constant from MPFR's own functions, to check output the pi reference file cannot
+static void mpfr_reference_constant(mpfr_t value)
+{
+    switch (constant)
     {
-        std::cout << "Reference Pi: " << reference_pi_trimmed << std::endl;
-        std::cout << "Computed Pi:  " << computed_pi_trimmed << std::endl;
+        case PiConstant::Pi:        mpfr_const_pi(value, MPFR_RNDN); break;
+        case PiConstant::E:         mpfr_set_ui(value, 1, MPFR_RNDN); mpfr_exp(value, value, MPFR_RNDN); break;
+        case PiConstant::Sqrt2:     mpfr_sqrt_ui(value, 2, MPFR_RNDN); break;
+        case PiConstant::Log2:      mpfr_const_log2(value, MPFR_RNDN); break;
+        case PiConstant::Zeta3:     mpfr_zeta_ui(value, 3, MPFR_RNDN); break;
+        case PiConstant::Catalan:   mpfr_const_catalan(value, MPFR_RNDN); break;
     }
+}
 
-    // Now compare the truncated values
-    if (computed_pi_trimmed == reference_pi_trimmed)
+// Write a constant other than pi, or pi in --base, to computed_<name>[_base<N>].txt (or
+// computed_<name>.bin for raw) and check the leading digits against MPFR, since the reference
+// file only holds decimal pi
+void write_constant_output(const std::vector<char>& output)
+{
+    bool raw = (output_base == 256);
+    std::string filename = "computed_" + constant_name +
+        (raw ? ".bin" : output_base == 10 ? ".txt" : "_base" + std::to_string(output_base) + ".txt");
+    size_t length = raw ? output.size() : std::strlen(output.data());
+
+    // Written in the background while MPFR computes the reference
+    AsyncFileWrite file;
+    file.start(filename, output.data(), length, raw ? "" : "\n", io_options);
+
+    std::optional<TraceSpan> verification_span;
+    verification_span.emplace("verification");
+    long long checked = std::min<long long>(decimal_places, 10000);
+    mpfr_t reference;
+    mpfr_init2(reference, static_cast<mpfr_prec_t>(checked * 4 + 64));
+    mpfr_reference_constant(reference);
+
+    bool match;
+    if (raw)
     {
-        print_verification_result(true, "Pi verification");
+        std::vector<unsigned char> expected(std::min(output.size(), PiContext::required_raw_bytes(checked)));
+        match = pi_format_raw(reference, expected.data(), expected.size()) == PiStatus::Ok &&
+                std::memcmp(expected.data(), output.data(), expected.size()) == 0;
     }
     else
     {
-        print_verification_result(false, "Pi verification");
+        long long digits = pi_digits_in_base(checked, output_base);
+        std::vector<char> expected(digits + 5);
+        match = pi_format_in_base(reference, output_base, digits, expected.data(), expected.size()) == PiStatus::Ok &&
+                std::strncmp(expected.data(), output.data(), std::strlen(expected.data())) == 0;
     }
+    mpfr_clear(reference);
+
+    verification_span.reset();
+
+    TraceSpan write_span("file write");
+    if (!file.wait())
+    {
+        std::cerr << "Error: Could not write " << filename << std::endl;
+        return;
+    }
+    std::cout << "[Main] " << constant_name << " in " << (raw ? std::string("raw bytes") : "base " + std::to_string(output_base))
+              << " written to " << filename << "\n";
+    print_verification_result(match, constant_name + " verification (leading digits against MPFR)");
 }
 
-// Function to Output the computed value for pi to a file.
-std::string write_computed_pi_to_file(const mpfr_t& pi_approx)
+// Function to Output the computed value for pi to a file. The write goes on in the
+// background; output.wait() finishes it. computed_digits must outlive the write.
+std::string write_computed_pi_to_file(const char* computed_digits, AsyncFileWrite& output)
 {
-    char* computed_pi_cstr = nullptr;
-    mpfr_asprintf(&computed_pi_cstr, "%.*Rf", static_cast<int>(decimal_places + 5), pi_approx);
-    std::string computed_pi_str(computed_pi_cstr);
-    mpfr_free_str(computed_pi_cstr);
+    std::string computed_pi_str(computed_digits);
 
     // Trim the computed_pi_str to requested decimal_places
     computed_pi_str = computed_pi_str.substr(0, decimal_places + 2); // "3." counts as first two characters
 
-    std::ofstream pi_file("computed_pi.txt");
-    if (pi_file)
-    {
-        pi_file << computed_pi_str << "\n";
-        pi_file.close();
-    }
-    else
-    {
-        std::cerr << "Error: Could not open file for writing π value." << std::endl;
-    }
+    output.start("computed_pi.txt", computed_digits, computed_pi_str.size(), "\n", io_options);
 
     return computed_pi_str;  // RETURN here
 }
 
-// Function to calculate pi using the Gauss_Legendre algorithm.
-void calculate_gauss_legendre_algorithm(mpfr_t pi_approx)
+// ********************   MAIN *******************************
+int main(int argc, char* argv[])
 {
-    iterations.store(log2(decimal_places) + 2, std::memory_order_relaxed);
+    trace_set_thread_name("main");
 
-    mpfr_t a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2;
-    mpfr_inits(a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, (mpfr_ptr) 0);
-
-    // Initialize variables
-    mpfr_set_d(a, 1.0, MPFR_RNDN);
-    mpfr_sqrt_ui(b, 2, MPFR_RNDN);
-    mpfr_ui_div(b, 1, b, MPFR_RNDN);
-    mpfr_set_d(t, 0.25, MPFR_RNDN);
-    mpfr_set_d(p, 1.0, MPFR_RNDN);
+    if (!parse_command_line(argc, argv))
+    {
+        return 1;  // Exit if parsing failed
+    }
 
-    for (long long i = 0; i < iterations; i++)
+    // --find: look the digits up in the index of an earlier result
+    if (!find_query.empty())
     {
-        // std::cerr << "Loop iteration " << i << "\n"; // Output the loop number.
+        auto start = std::chrono::steady_clock::now();
+        long long place = find_in_digits(find_file, find_query, std::max(1, container_limits().effective_cpus), debug_level);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (place < 0) return 1;
+        if (place == 0)
+            std::cout << "[Find] " << find_query << " does not occur in " << find_file << "\n";
+        else
+            std::cout << "[Find] " << find_query << " first occurs at decimal place " << place << " (" << ms << " ms)\n";
+        return 0;
+    }
 
-        iteration_counter.store(i + 1, std::memory_order_relaxed);  // For monitoring
-        if (stop_requested.load(std::memory_order_seq_cst))
+    // --tune: time this host and save the profile later runs load
+    if (run_tune)
+    {
+        std::string path = profile_path.empty() ? default_profile_path() : profile_path;
+        std::cout << "[Tune] Calibrating on " << describe_container_limits() << ", runs of up to "
+                  << decimal_places << " decimal places\n";
+        HostProfile profile = tune_host_profile(decimal_places, debug_level);
+        if (!save_host_profile(path, profile)) return 1;
+
+        std::cout << "[Tune] " << profile.threads << " threads, leaf size " << profile.leaf_size
+                  << ", chunk size " << profile.chunk_size << ", NTT multiply ";
+        if (profile.ntt_threshold > 0) std::cout << "from " << profile.ntt_threshold << " limbs\n";
+        else std::cout << "off\n";
+        for (const auto& crossover : profile.methods)
         {
-            // std::cerr << "[Interrupt] Cntrl+C received. Cleaning up and exiting early.\n";
-            mpfr_clears(a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, pi_approx, (mpfr_ptr) 0);  // Clean up
-            std::exit(1);  //exit cleanly without printing a result.
+            std::cout << "[Tune] " << crossover.method << " from " << crossover.from_digits << " decimal places\n";
         }
+        std::cout << "[Tune] Profile written to " << path << "\n";
+        return 0;
+    }
 
-        // a_next = (a + b) / 2.0
-        mpfr_add(a_next, a, b, MPFR_RNDN);
-        mpfr_div_ui(a_next, a_next, 2, MPFR_RNDN);
-
-        // b_next = sqrt(a * b)
-        mpfr_mul(b_next, a, b, MPFR_RNDN);
-        mpfr_sqrt(b_next, b_next, MPFR_RNDN);
-
-        // t_next = t - p * (a - a_next)^2
-        mpfr_sub(temp1, a, a_next, MPFR_RNDN);
-        mpfr_mul(temp1, temp1, temp1, MPFR_RNDN);
-        mpfr_mul(temp1, p, temp1, MPFR_RNDN);
-        mpfr_sub(t_next, t, temp1, MPFR_RNDN);
+    // Startup banner: what the host or container actually gives us
+    std::cerr << "[Info] Resources: " << describe_container_limits() << "\n";
+    long long available_memory = container_available_memory_bytes();
+    long long estimated_memory = estimate_peak_memory_bytes(thread_count);
+    if (available_memory > 0 && estimated_memory > available_memory)
+    {
+        std::cerr << "⚠️ Warning: Estimated peak memory " << estimated_memory / (1024 * 1024) << " MB exceeds the "
+                  << available_memory / (1024 * 1024) << " MB available. The run may be OOM-killed.\n";
+    }
+    else if (debug_level >= 1)
+    {
+        std::cerr << "[Info] Estimated peak memory " << estimated_memory / (1024 * 1024) << " MB of "
+                  << available_memory / (1024 * 1024) << " MB available\n";
+    }
 
-        // p_next = 2 * p
-        mpfr_mul_ui(p_next, p, 2, MPFR_RNDN);
+    // Reference data used while debugging.
+    std::vector<std::string> reference_terms = load_reference_values("reference_terms.txt");
+    std::vector<std::string> reference_sums  = load_reference_values("reference_sums.txt");
 
-        // Update
-        mpfr_set(a, a_next, MPFR_RNDN);
-        mpfr_set(b, b_next, MPFR_RNDN);
-        mpfr_set(t, t_next, MPFR_RNDN);
-        mpfr_set(p, p_next, MPFR_RNDN);
+    // Hardware counters must be enabled before the first span is opened
+    if (use_perf_counters)
+    {
+        perf_counters_enable();
     }
 
-    // Compute pi_approx = (a + b)^2 / (4 * t)
-    mpfr_add(temp1, a, b, MPFR_RNDN);
-    mpfr_mul(temp1, temp1, temp1, MPFR_RNDN);
-    mpfr_mul_ui(temp2, t, 4, MPFR_RNDN);
-    mpfr_div(pi_approx, temp1, temp2, MPFR_RNDN);
-
-    if (debug_level >=2)
+    // Spans are kept only when something reports them. A daemon never prints the phase
+    // summary, so there only --trace keeps them.
+    if (!trace_filename.empty() || (debug_level >= 1 && serve_socket.empty()))
     {
-        mpfr_printf("Final computed pi_approx=%.*Rf\n", decimal_places, pi_approx);
+        trace_recording_enable();
     }
 
-    // Free temp variables
-    mpfr_clears(a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, (mpfr_ptr) 0);
-}
+    // Energy accounting takes its first reading here so the whole run is counted
+    if (use_energy || debug_level >= 2)
+    {
+        energy_monitoring_enable();
+    }
 
-// Function to compute factorial of k using MPFR
-void mpfr_factorial(mpfr_t result, unsigned long k)
-{
-    mpz_t fac;
-    mpz_init(fac);
-    mpz_fac_ui(fac, k);
-    //mpfr_set_z(result, fac, MPFR_RNDN);
-    mpfr_set_z(result, fac, MPFR_RNDZ);  // RNDZ = round toward zero (truncate)
-    mpz_clear(fac);
-}
+    // Metrics file, format taken from the extension unless given
+    if (!metrics_filename.empty())
+    {
+        if (metrics_format.empty())
+        {
+            bool json_name = metrics_filename.size() >= 5 &&
+                (metrics_filename.compare(metrics_filename.size() - 5, 5, ".json") == 0 ||
+                 (metrics_filename.size() >= 6 && metrics_filename.compare(metrics_filename.size() - 6, 6, ".jsonl") == 0));
+            metrics_format = json_name ? "json" : "prom";
+        }
+        if (!metrics_exporter.open(metrics_filename, metrics_format))
+        {
+            return 1;
+        }
+    }
 
-void calculate_chudnovsky_algorithm(
-    mpfr_t pi_approx,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
-{
+    // NTT for the largest binary splitting products. It needs the three transforms on separate
+    // cores to beat mpz_mul, so by default it is on from three threads.
+    if (ntt_threshold < 0)
+    {
+        ntt_threshold = (thread_count >= 3) ? NTT_DEFAULT_THRESHOLD_LIMBS : 0;
+    }
+    if (!ntt_configure(ntt_threshold, thread_count, ntt_kernel))
+    {
+        std::cerr << "Error: This CPU does not support the " << ntt_kernel << " NTT kernel.\n";
+        return 1;
+    }
+    if (debug_level >= 1)
+    {
+        std::cerr << "[Info] NTT multiply: " << ntt_kernel_name() << " kernel, ";
+        if (ntt_threshold > 0) std::cerr << "operands of " << ntt_threshold << " limbs and up\n";
+        else std::cerr << "off\n";
+    }
+    self_check_configure(use_self_check);
 
-    // Compute working precision in bits
-    working_prec = get_chudnovsky_precision(decimal_places);
-    if (debug_level >= 2)
+    if (io_options.backend == "uring" && std::strcmp(async_io_backend(io_options), "io_uring") != 0)
+    {
+        std::cerr << "⚠️ Warning: io_uring is not available here, file I/O uses the thread pool.\n";
+    }
+    if (debug_level >= 1)
     {
-        printf("Working precision: %ld bits\n", working_prec);
+        std::cerr << "[Info] File I/O: " << async_io_backend(io_options) << ", depth " << io_options.depth
+                  << (io_options.direct ? ", O_DIRECT writes\n" : "\n");
     }
 
-    // DJP Each method now sets it's own default precision
-    // Set global MPFR default precision as a safety net
-    //mpfr_set_default_prec(working_prec);
+    // ******************* Engine options   *******************
+    PiOptions options;
+    options.decimal_places = decimal_places;
+    options.debug_level = debug_level;
+    options.reference_terms = std::move(reference_terms);
+    options.reference_sums = std::move(reference_sums);
+    options.fingerprint_checks = fingerprint_checks;
+    options.cache_dir = cache_dir;
+    options.constant = constant;
+    options.leaf_size = leaf_size;
+    options.chunk_size = chunk_size;
+    options.factorized = use_factorized;
+    if (use_merge) options.merge_dir = shard_dir;
+
+    if (calculation_method == "chudnovsky" || calculation_method == "binary_splitting")
+    {
+        // Validate thread count request from command line.
+        int max_threads = container_limits().effective_cpus;
 
-    // Call the single-threaded calculation function
-    ChudnovskyTermCalculator calculator(working_prec, debug_level);
-    calculator.calculate_chudnovsky_singlethreaded(pi_approx, working_prec, reference_terms, reference_sums);
+        if (thread_count <= 0 || thread_count > max_threads)
+        {
+            std::cerr << "Warning: Requested " << thread_count << " threads, but only "
+                  << (max_threads + 1) << " available.\n";
+            thread_count = std::max(1, max_threads);  // adjust
+            std::cerr << "Using " << thread_count << " threads instead.\n";
+        }
 
-}
+        options.method = (calculation_method == "binary_splitting") ? PiMethod::BinarySplitting : PiMethod::Chudnovsky;
+        options.threads = thread_count;
+        options.dynamic = use_dynamic;
+    }
 
-// ********************   MAIN *******************************
-int main(int argc, char* argv[])
-{
-    if (!parse_command_line(argc, argv))
+    // Daemon mode: compute (or load) the digits, then serve ranges until stopped
+    if (!serve_socket.empty())
     {
-        return 1;  // Exit if parsing failed
+        DigitServerConfig server_config;
+        server_config.socket_path = serve_socket;
+        server_config.initial_digits = decimal_places;
+        server_config.max_digits = serve_max_digits;
+        server_config.compute_options = std::move(options);
+        return run_digit_server(server_config);
     }
 
-    // Reference data used while debugging.
-    std::vector<std::string> reference_terms = load_reference_values("reference_terms.txt");
-    std::vector<std::string> reference_sums  = load_reference_values("reference_sums.txt");
+    PiContext context(std::move(options));
+    pi_context = &context;
 
     // Register Stop Handler
     std::signal(SIGINT, signal_handler);
@@ -1077,82 +1619,182 @@ int main(int argc, char* argv[])
         std::cout << "[Main] Calculating pi to " << decimal_places << " decimal places.\n";
     }
 
-    mpfr_t pi_approx;
-
     // ******************* Start Gauss Legendre   *******************
     if (calculation_method == "gauss_legendre")
     {
         std::cerr << "[Main] Using Single Threaded Gauss Legendre Algorithm \n";
-        //<TODO> Consider changing precision to gl_precision
-        long long precision = static_cast<long long>(decimal_places + 5) * 4;
-        mpfr_set_default_prec(precision);  // Set function precision
-        mpfr_init2(pi_approx, precision);
-        calculate_gauss_legendre_algorithm(pi_approx);
     }
 
     // ******************* Start Chudnovsky   *******************
     else if (calculation_method == "chudnovsky")
     {
-
-        // Compute chudnovsky default working precision in bits
-        working_prec = get_chudnovsky_precision(decimal_places);
-        mpfr_set_default_prec(working_prec);
-        mpfr_init2(pi_approx, working_prec);
-
         if (debug_level >= 2)
         {
-            std::cout << "[Main] MPFR default chudnovsky precision set to " << working_prec << " bits.\n";
+            std::cout << "[Main] Chudnovsky working precision set to " << context.precision() << " bits.\n";
         }
-        
-        // Validate thread count request from command line.
-        int max_threads = std::max(1u, std::thread::hardware_concurrency());
 
-        if (thread_count <= 0 || thread_count > max_threads)
+        if (debug_level >= 1 && thread_count > 1)
         {
-            std::cerr << "Warning: Requested " << thread_count << " threads, but only "
-                  << (max_threads + 1) << " available.\n";
-            thread_count = std::max(1, max_threads);  // adjust
-            std::cerr << "Using " << thread_count << " threads instead.\n";
+            print_placement_plan(thread_count);
         }
 
-        if (thread_count > 1)
+        if (thread_count > 1 && use_dynamic)
         {
-            if (use_dynamic)
-            {
-                std::cout << "[Main] Using dynamic multithreaded Chudnovsky Algorithm\n";
-                set_dynamic_chunks(chunk_size);
-                
-                //calculate_pi_chudnovsky_dynamic(thread_count, pi_approx);
-                calculate_pi_chudnovsky_dynamic(thread_count, pi_approx, reference_terms, reference_sums);
-            }
-            else 
-            {
-                std::cerr << "[Main] Using static multithreaded Chudnovsky Algorithm \n";
-                calculate_pi_multithreaded(ChudnovskyTermCalculator::estimate_required_k(decimal_places), pi_approx, reference_terms, reference_sums);
-            }
+            std::cout << "[Main] Using dynamic multithreaded Chudnovsky Algorithm\n";
+        }
+        else if (thread_count > 1)
+        {
+            std::cerr << "[Main] Using static multithreaded Chudnovsky Algorithm \n";
         }
         else
         {
             std::cerr << "[Main] Using single-threaded ChudnovskyAlgorithm \n";
-            calculate_chudnovsky_algorithm(pi_approx, reference_terms, reference_sums);
         }
     }
-    
-    // Output the computed value to file
-    std::string computed_pi_str = write_computed_pi_to_file(pi_approx);
 
-    // Trim to requested decimal places
-    computed_pi_str = computed_pi_str.substr(0, decimal_places + 2); // + 2 for "3."
+    // ******************* Start Binary Splitting   *******************
+    else if (calculation_method == "binary_splitting")
+    {
+        if (debug_level >= 1 && thread_count > 1)
+        {
+            print_placement_plan(thread_count);
+        }
+        if (constant != PiConstant::Pi)
+            std::cerr << "[Main] Computing " << constant_name << " by binary splitting of its series with " << thread_count << " thread(s)\n";
+        else
+            std::cerr << "[Main] Using Chudnovsky binary splitting with " << thread_count << " thread(s)\n";
+    }
+
+    // The library writes "3." and the digits straight into this buffer
+    std::vector<char> digits;
+    PiStatus status;
+    if (shard_count > 0)
+    {
+        status = compute_shard(context, shard_index, shard_count, shard_dir);
+    }
+    else if (output_base == 256)
+    {
+        digits.resize(PiContext::required_raw_bytes(decimal_places));
+        status = context.compute_raw(reinterpret_cast<unsigned char*>(digits.data()), digits.size());
+    }
+    else if (output_base != 10)
+    {
+        digits.resize(PiContext::required_buffer_size_in_base(decimal_places, output_base));
+        status = context.compute_in_base(output_base, digits.data(), digits.size());
+    }
+    else
+    {
+        digits.resize(PiContext::required_buffer_size(decimal_places));
+        status = context.compute(digits.data(), digits.size());
+    }
+
+    if (status != PiStatus::Ok)
+    {
+        stop_monitoring();
+        monitor_thread.join();
+        if (status == PiStatus::Cancelled)
+            std::cerr << "Calculation aborted by user.\n";
+        else
+            std::cerr << "[Error] Calculation failed: " << pi_status_string(status) << "\n";
+        return 1;
+    }
+
+    if (context.served_from_cache())
+    {
+        std::cerr << "[Main] " << decimal_places << " decimal places served from the cache in " << cache_dir << "\n";
+    }
+
+    if (shard_count > 0)
+    {
+        std::cerr << "[Main] Shard " << shard_index << "/" << shard_count << " written to "
+                  << shard_file_path(shard_dir, shard_index, shard_count) << "\n";
+    }
+    else if (output_base != 10 || constant != PiConstant::Pi)
+    {
+        write_constant_output(digits);
+    }
+    else if (!batch_targets.empty())
+    {
+        // One output file and one verification per target
+        write_batch_outputs(digits.data());
+    }
+    else
+    {
+        // Output the computed value to file
+        AsyncFileWrite output;
+        std::string computed_pi_str = write_computed_pi_to_file(digits.data(), output);
+
+        // Trim to requested decimal places
+        computed_pi_str = computed_pi_str.substr(0, decimal_places + 2); // + 2 for "3."
+
+        // Verify result while the file is written
+        verify_pi_from_file(computed_pi_str);
+
+        {
+            TraceSpan write_span("file write");
+            if (!output.wait())
+            {
+                std::cerr << "Error: Could not write π value to computed_pi.txt." << std::endl;
+                build_index = false;
+            }
+        }
 
-    // Verify result
-    verify_pi_from_file(computed_pi_str);
+        if (build_index)
+        {
+            TraceSpan index_span("index");
+            int index_threads = std::max(1, container_limits().effective_cpus);
+            if (build_digit_index(digits.data() + 2, decimal_places, "computed_pi.txt", index_threads, debug_level))
+                std::cout << "[Main] Digit index written to " << digit_index_path("computed_pi.txt") << "\n";
+            else
+                std::cerr << "Error: Could not write " << digit_index_path("computed_pi.txt") << std::endl;
+        }
+    }
 
     // Stop monitoring thread
-    keep_monitoring = false;
+    stop_monitoring();
     monitor_thread.join();
 
-    // Free memory
-    mpfr_clear(pi_approx);
+    if (debug_level >= 1)
+    {
+        print_system_summary();
+    }
+
+    // Final energy sample, then per domain and per phase totals
+    if (energy_monitoring_enabled())
+    {
+        monitor_power_usage(trace_current_phase());
+        print_accumulated_energy();
+        print_energy_report(decimal_places);
+    }
+
+    // Final metrics record so collectors see the run as finished
+    if (metrics_exporter.enabled())
+    {
+        SystemSample final_sample;
+        system_sampler.latest(final_sample);
+        export_metrics(final_sample, true);
+        metrics_exporter.close();
+    }
+
+    // Report where the time went
+    if (debug_level >= 1 || !trace_filename.empty())
+    {
+        print_phase_summary();
+    }
+    print_perf_counter_summary();
+    if (use_self_check)
+    {
+        SelfCheckCounts counts = self_check_counts();
+        if (debug_level >= 1 || counts.failed > 0)
+        {
+            std::cerr << "[Info] Self-check: " << counts.checked << " operations checked, "
+                      << counts.failed << " failed and redone\n";
+        }
+    }
+    if (!trace_filename.empty() && write_chrome_trace(trace_filename))
+    {
+        std::cout << "[Main] Trace written to " << trace_filename << "\n";
+    }
     
     std::cout << "[Main] Done.\n";
     return 0;
@@ -11,6 +11,12 @@
 #include <mutex>
 #include <thread>
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include "instrumentation.hpp"
+#include "thread_placement.hpp"
+#include "series_constants.hpp"
 //#include <iostream>
 #include <mpfr.h>
 //#include "chudnovsky.hpp"
@@ -19,52 +25,12 @@
 
 
 
-extern std::atomic<bool> stop_requested;
-extern std::atomic<int> current_k;
-extern int max_k;
-//extern int chunk_size;
-
-extern std::atomic<unsigned long> iterations;
-extern std::atomic<unsigned long> iteration_counter;
-
-// Global chunk management variables
-std::atomic<int> current_k(0);
-int max_k = 0;
-int chunk_size = 100; // Default, can be overwritten
-
-struct ChudnovskyScratchpad {
-    mpfr_t term, num, den, k_mp, k3_mp;
-    mpz_t fact_k, fact_3k, fact_6k, pow_640320;
-
-    // temps for numerator/denominator construction
-    mpz_t tmp1, tmp2, tmp3, tmp4, tmp5;
-
-    unsigned long last_k;
-
-    ChudnovskyScratchpad(mpfr_prec_t working_prec) {
-        mpfr_init2(term, working_prec);
-        mpfr_init2(num, working_prec);
-        mpfr_init2(den, working_prec);
-        mpfr_init2(k_mp, working_prec);
-        mpfr_init2(k3_mp, working_prec);
-
-        //mpz_inits(fact_k, fact_3k, fact_6k, pow_640320, nullptr);
-        mpz_inits(fact_k, fact_3k, fact_6k, pow_640320,
-            tmp1, tmp2, tmp3, tmp4, tmp5,
-            nullptr);
-
-        last_k = 0;
-        mpz_fac_ui(fact_k, 0);
-        mpz_fac_ui(fact_3k, 0);
-        mpz_fac_ui(fact_6k, 0);
-        mpz_set_ui(pow_640320, 1);
-    }
-    ~ChudnovskyScratchpad() {
-        mpfr_clears(term, num, den, k_mp, k3_mp, (mpfr_ptr) 0);
-        mpz_clears(fact_k, fact_3k, fact_6k, pow_640320,
-            tmp1, tmp2, tmp3, tmp4, tmp5,
-            nullptr);
-    }
+// Chunk hand-out state for one dynamic computation
+struct DynamicSchedule
+{
+    std::atomic<int> current_k{0};
+    int max_k = 0;
+    int chunk_size = 100;
 };
 
 // Chudnovsky Term Calucalation for Dynamic k distribution
@@ -77,13 +43,13 @@ void compute_chudnovsky_term(mpfr_t& term, long k, ChudnovskyScratchpad& scratch
 
     // Denominator: (3k)! * (k!)^3 * (640320)^(3k)
     mpz_mul(scratch.tmp3, scratch.tmp3, scratch.tmp2);
-    mpz_ui_pow_ui(scratch.tmp4, 640320, 3 * k);
+    mpz_ui_pow_ui(scratch.tmp4, ChudnovskyPi::C, 3 * k);
     mpz_mul(scratch.tmp4, scratch.tmp4, scratch.tmp3); // full denominator
 
     // Numerator: (6k)! * (545140134 * k + 13591409)
     mpz_set_ui(scratch.tmp5, k); // a new scratch value for k
-    mpz_mul_ui(scratch.tmp2, scratch.tmp5, 545140134); // 545140134 * k
-    mpz_add_ui(scratch.tmp2, scratch.tmp2, 13591409);  // + 13591409
+    mpz_mul_ui(scratch.tmp2, scratch.tmp5, ChudnovskyPi::B); // 545140134 * k
+    mpz_add_ui(scratch.tmp2, scratch.tmp2, ChudnovskyPi::A);  // + 13591409
     mpz_mul(scratch.tmp2, scratch.tmp1, scratch.tmp2); // (6k)! * (...)
 
     if (k % 2 != 0) {
@@ -94,23 +60,26 @@ void compute_chudnovsky_term(mpfr_t& term, long k, ChudnovskyScratchpad& scratch
     mpfr_set_z(scratch.num, scratch.tmp2, MPFR_RNDN);
     mpfr_set_z(scratch.den, scratch.tmp4, MPFR_RNDN);
     mpfr_div(term, scratch.num, scratch.den, MPFR_RNDN);
-
-    if (debug_level >= 3) {
-        std::lock_guard<std::mutex> lock(console_mutex);
-        mpfr_printf("[compute_chudnovsky_term] Term k=%ld: %.Re\n", k, term);
-    }
 }
 
 
-ChudnovskyTermCalculator::ChudnovskyTermCalculator(mpfr_prec_t precision, int debug_level)
-    : prec(precision), debug(debug_level) {
+ChudnovskyTermCalculator::ChudnovskyTermCalculator(mpfr_prec_t precision, int debug_level, bool fingerprints)
+    : prec(precision), debug(debug_level), fingerprints(fingerprints) {
     mpfr_inits2(prec, mp_k, mp_3k, power_neg1,
     power_640320, multiplier, num, den, (mpfr_ptr) 0);
+    mpz_init(power_of_ten);
 }
 
 ChudnovskyTermCalculator::~ChudnovskyTermCalculator() {
     mpfr_clears(mp_k, mp_3k, power_neg1,
     power_640320, multiplier, num, den, (mpfr_ptr) 0);
+    mpz_clear(power_of_ten);
+}
+
+// Caculate the working precision for the chudnovsky algorithm to use.
+mpfr_prec_t get_chudnovsky_precision(long long decimal_places, int buffer)
+{
+    return static_cast<mpfr_prec_t>(ceil(decimal_places * 3.322 + buffer));
 }
 
 unsigned long ChudnovskyTermCalculator::estimate_required_k(long long decimal_places) 
@@ -119,19 +88,85 @@ unsigned long ChudnovskyTermCalculator::estimate_required_k(long long decimal_pl
     return static_cast<unsigned long>(decimal_places / DIGITS_PER_TERM) + 1;
 }
 
-void set_dynamic_chunks(int chunk) {
-    chunk_size = chunk;
-    current_k = 0;
+static void set_dynamic_chunks(DynamicSchedule& schedule, int chunk, long long decimal_places, int debug_level) {
+    schedule.chunk_size = chunk;
+    schedule.current_k = 0;
     // Approximate how many terms based on decimal places
-    max_k = static_cast<int>((decimal_places / 14.181647462) + 10); 
+    schedule.max_k = static_cast<int>((decimal_places / 14.181647462) + 10);
     std::lock_guard<std::mutex> lock(console_mutex);
     if (debug_level >=2)
     {
-        std::cerr << "[set_dynamic_chunks] max_k = " << max_k << "\n";
+        std::cerr << "[set_dynamic_chunks] max_k = " << schedule.max_k << "\n";
     }
 }
 
-void ChudnovskyTermCalculator::compare_value(
+// Fingerprint moduli: the two largest primes below 2^64
+static constexpr uint64_t FINGERPRINT_PRIMES[2] = {18446744073709551557ULL, 18446744073709551533ULL};
+
+DecimalFingerprint ChudnovskyTermCalculator::fingerprint_decimal(const std::string& text, long long places)
+{
+    DecimalFingerprint fingerprint = {{0, 0}, false};
+    bool nonzero = false;
+    long long decimals = -1;                // Digits seen after the point, -1 before it
+    for (char c : text)
+    {
+        if (c == '.')
+        {
+            decimals = 0;
+            continue;
+        }
+        if (c < '0' || c > '9') continue;
+        if (decimals >= places) break;
+        for (int i = 0; i < 2; ++i)
+        {
+            unsigned __int128 r = static_cast<unsigned __int128>(fingerprint.residue[i]) * 10 + (c - '0');
+            fingerprint.residue[i] = static_cast<uint64_t>(r % FINGERPRINT_PRIMES[i]);
+        }
+        nonzero = nonzero || c != '0';
+        if (decimals >= 0) ++decimals;
+    }
+
+    // Fewer decimals written than asked for: the rest are zeros
+    for (long long d = std::max(decimals, 0LL); d < places; ++d)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            unsigned __int128 r = static_cast<unsigned __int128>(fingerprint.residue[i]) * 10;
+            fingerprint.residue[i] = static_cast<uint64_t>(r % FINGERPRINT_PRIMES[i]);
+        }
+    }
+    fingerprint.negative = nonzero && !text.empty() && text[0] == '-';
+    return fingerprint;
+}
+
+DecimalFingerprint ChudnovskyTermCalculator::fingerprint_value(const mpfr_t value, long long places)
+{
+    if (power_places != places)
+    {
+        mpz_ui_pow_ui(power_of_ten, 10, static_cast<unsigned long>(places));
+        power_places = places;
+    }
+
+    // trunc(value * 10^places): one multiplication and a conversion, no decimal string
+    mpfr_t scaled;
+    mpfr_init2(scaled, mpfr_get_prec(value) + 64);
+    mpfr_mul_z(scaled, value, power_of_ten, MPFR_RNDZ);
+    mpz_t digits;
+    mpz_init(digits);
+    mpfr_get_z(digits, scaled, MPFR_RNDZ);
+
+    DecimalFingerprint fingerprint;
+    fingerprint.negative = mpz_sgn(digits) < 0;
+    mpz_abs(digits, digits);
+    for (int i = 0; i < 2; ++i)
+        fingerprint.residue[i] = mpz_fdiv_ui(digits, FINGERPRINT_PRIMES[i]);
+
+    mpz_clear(digits);
+    mpfr_clear(scaled);
+    return fingerprint;
+}
+
+bool ChudnovskyTermCalculator::compare_value(
     const std::string& label,
     const mpfr_t value,
     const std::vector<std::string>& reference_values,
@@ -143,6 +178,30 @@ void ChudnovskyTermCalculator::compare_value(
     constexpr const char* RED = "\033[31m";
     constexpr const char* RESET = "\033[0m";
 
+    // Fingerprints first: O(n) work per value instead of a decimal conversion, and strings
+    // only when they disagree
+    if (fingerprints)
+    {
+        if (static_cast<size_t>(k) >= reference_values.size())
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cerr << RED << "No reference value for k=" << k << " (" << label << ")" << RESET << "\n";
+            return true;
+        }
+
+        const std::string& ref_str = reference_values[k];
+        size_t point = ref_str.find('.');
+        long long ref_places = (point == std::string::npos) ? 0 : static_cast<long long>(ref_str.size() - point - 1);
+        long long places = std::min(decimal_places, ref_places);
+        if (fingerprint_value(value, places) == fingerprint_decimal(ref_str, places))
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cout << GREEN << "✅ " << label << " matches reference at k=" << k << " (" << places
+                      << " places by fingerprint) ✅" << RESET << "\n";
+            return true;
+        }
+    }
+
     // Number of decimal places + safety buffer for rounding
     long long print_digits = decimal_places + 5;
 
@@ -177,12 +236,14 @@ void ChudnovskyTermCalculator::compare_value(
             if (trimmed_test == trimmed_ref)
             {
                 std::cout << GREEN << "✅ " << label << " matches reference at k=" << k << " ✅" << RESET << "\n";
+                return true;
             }
             else
             {
                 std::cout << RED << "❌ " << label << " does NOT match reference at k=" << k << " ❌\n"
                           << "  Actual   : " << trimmed_test << "\n"
                           << "  Reference: " << trimmed_ref << RESET << "\n";
+                return false;
             }
         }
     }
@@ -191,10 +252,11 @@ void ChudnovskyTermCalculator::compare_value(
         std::lock_guard<std::mutex> lock(console_mutex);
         std::cerr << RED << "No reference value for k=" << k << " (" << label << ")" << RESET << "\n";
     }
+    return true;
 }
 
-// Compare two strings character by character up to min length
-void ChudnovskyTermCalculator::compare_strings_verbose(const std::string& label, const std::string& s1, const std::string& s2)
+// Compare two strings character by character up to min length, reporting the first difference
+bool ChudnovskyTermCalculator::compare_strings_verbose(const std::string& label, const std::string& s1, const std::string& s2)
 {
     size_t min_len = std::min(s1.size(), s2.size());
     bool match = true;
@@ -209,8 +271,7 @@ void ChudnovskyTermCalculator::compare_strings_verbose(const std::string& label,
                       << "  Actual   : ..." << s1.substr(i, 20) << "...\n"
                       << "  Reference: ..." << s2.substr(i, 20) << "...\n"
                       << "\033[0m";
-            //break;
-            std::exit(1);
+            break;
         }
     }
 
@@ -220,6 +281,7 @@ void ChudnovskyTermCalculator::compare_strings_verbose(const std::string& label,
                   << "Strings match up to " << min_len << " characters ✅"
                   << "\033[0m\n";
     }
+    return match;
 }
 
 void ChudnovskyTermCalculator::init_scratchpad_at_k(ChudnovskyScratchpad& scratch, unsigned long k) {
@@ -243,14 +305,14 @@ void ChudnovskyTermCalculator::compute_term(mpfr_t result, unsigned long k, Chud
     mpz_fac_ui(scratch.fact_k, k_val);
     mpz_fac_ui(scratch.fact_3k, k3_val);
     mpz_fac_ui(scratch.fact_6k, k6_val);
-    mpz_ui_pow_ui(scratch.pow_640320, 640320, k3_val);
+    mpz_ui_pow_ui(scratch.pow_640320, ChudnovskyPi::C, k3_val);
 
     // Calculate multiplier = 545140134*k + 13591409
     mpz_t multiplier;
     mpz_init(multiplier);
-    mpz_set_ui(multiplier, 545140134);
+    mpz_set_ui(multiplier, ChudnovskyPi::B);
     mpz_mul_ui(multiplier, multiplier, k);
-    mpz_add_ui(multiplier, multiplier, 13591409);
+    mpz_add_ui(multiplier, multiplier, ChudnovskyPi::A);
 
     // Calculate numerator = (-1)^k * (6k)! * multiplier
     mpz_t numerator;
@@ -282,30 +344,39 @@ void ChudnovskyTermCalculator::compute_term(mpfr_t result, unsigned long k, Chud
     mpz_clear(denominator);
 }
 
+template <int DebugLevel>
 void ChudnovskyTermCalculator::chudnovsky_worker(
+    PiContext& context,
     int thread_id,
     int start_term,
     int end_term,
-    mpfr_t* shared_results,
-    mpfr_prec_t working_prec,
-    int debug_level,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
+    mpfr_t* shared_results)
 {
     using namespace std::chrono;
 
+    const PiOptions& options = context.options();
+    const mpfr_prec_t working_prec = context.precision();
+    constexpr int debug_level = DebugLevel;
+    const long long decimal_places = options.decimal_places;
+    const std::vector<std::string>& reference_terms = options.reference_terms;
+    const std::vector<std::string>& reference_sums = options.reference_sums;
+
     // Start a timer for the current thread
     auto start_time = high_resolution_clock::now();
+    placement_apply(thread_id);
+    trace_set_thread_name("worker " + std::to_string(thread_id));
+    TraceSpan worker_span("series", "worker", start_term);
+    std::optional<TraceSpan> chunk_span;
  
     // Create a thread-local calculator (scratchpad)
-    ChudnovskyTermCalculator calculator(working_prec, debug_level);
+    ChudnovskyTermCalculator calculator(working_prec, debug_level, options.fingerprint_checks);
 
     // Local sum to accumulate results
     mpfr_t local_sum;
     mpfr_init2(local_sum, working_prec +256);
     mpfr_set_zero(local_sum, 1); // positive zero
 
-    if (debug_level >= 1)
+    if constexpr (debug_level >= 1)
     {
        std::lock_guard<std::mutex> lock(console_mutex);
        std::cerr << "[Thread " << thread_id << "] Starting work from " << start_term << " to " << end_term -1 << "\n";
@@ -316,32 +387,41 @@ void ChudnovskyTermCalculator::chudnovsky_worker(
 
     for (int k = start_term; k < end_term; ++k)
     {
-        if (stop_requested.load())
+        // Record the work in chunk_size blocks so the trace shows progress through the range
+        if ((k - start_term) % options.chunk_size == 0)
         {
-            std::lock_guard<std::mutex> lock(console_mutex);
-            std::cerr << "[Thread " << thread_id << "] Stopping early due to interrupt.\n";
-            // break;
-            std::exit(1);
+            chunk_span.reset();
+            chunk_span.emplace("chunk", "chunk", k);
+        }
+
+        if (context.cancelled())
+        {
+            if constexpr (debug_level >= 1)
+            {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                std::cerr << "[Thread " << thread_id << "] Stopping early due to interrupt.\n";
+            }
+            break;
         }
         mpfr_t term;
         mpfr_init2(term, working_prec);
 
         calculator.compute_term(term, k, scratch);
 
-        // if (debug_level >= 3 && k < reference_terms.size()) 
-        if (debug_level >= 3 && static_cast<size_t>(k) < reference_terms.size())
+        if constexpr (debug_level >= 3)
         {
-            calculator.compare_value("term", term, reference_terms, k, decimal_places);
+            if (static_cast<size_t>(k) < reference_terms.size())
+                calculator.compare_value("term", term, reference_terms, k, decimal_places);
         }
 
         mpfr_add(local_sum, local_sum, term, MPFR_RNDN);
 
         // Add one to the progress counter for the monitoring thread.
-        iteration_counter.fetch_add(1, std::memory_order_relaxed);
+        context.add_progress(1);
 
-        if (debug_level >= 3 && thread_id == 0)
+        if constexpr (debug_level >= 3)
         {
-           calculator.compare_value("sum", local_sum, reference_sums, k, decimal_places);
+            if (thread_id == 0) calculator.compare_value("sum", local_sum, reference_sums, k, decimal_places);
         }
 
         // DJP NOTE:
@@ -388,13 +468,15 @@ void ChudnovskyTermCalculator::chudnovsky_worker(
 
         mpfr_clear(term);
     }
-    if(debug_level >= 1 )
+    chunk_span.reset();
+
+    if constexpr (debug_level >= 1)
     {
         std::lock_guard<std::mutex> lock(console_mutex);
         std::cerr << "[Thread " << thread_id << "] Finished work normally.\n";
     }
 
-    if (debug_level >= 3)
+    if constexpr (debug_level >= 3)
     {
         std::lock_guard<std::mutex> lock(console_mutex);
         std::cerr << "[Thread " << thread_id << "] Local sum = ";
@@ -407,7 +489,7 @@ void ChudnovskyTermCalculator::chudnovsky_worker(
 
     mpfr_clear(local_sum);
 
-    if(debug_level >= 1)
+    if constexpr (debug_level >= 1)
     {
         // Calculate the duration
         auto end_time = high_resolution_clock::now();
@@ -419,45 +501,218 @@ void ChudnovskyTermCalculator::chudnovsky_worker(
 }
 
 
-void chudnovsky_worker_dynamic(
+// Multithreaded Chudnovsky calculation
+// Partition terms among threads
+// Launch threads and wait for them to finish
+// Combine partial results into final sum
+
+PiStatus calculate_pi_multithreaded(PiContext& context, mpfr_t pi_approx)
+{
+    const PiOptions& options = context.options();
+    const mpfr_prec_t working_prec = context.precision();
+    const int debug_level = options.debug_level;
+    const long long decimal_places = options.decimal_places;
+    const int thread_count = options.threads;
+    const int max_terms = static_cast<int>(ChudnovskyTermCalculator::estimate_required_k(decimal_places));
+
+    if (debug_level >=2)
+    {
+       std::cerr << "Using " << thread_count << " worker threads for Chudnovsky calculation.\n";
+    }
+
+    context.set_progress_total(max_terms);
+
+    if (debug_level >=2)
+    {
+        std::cout << "working precission= " << working_prec << " \n";
+    }
+
+    // Allocate space for thread results
+    mpfr_t* shared_results = new mpfr_t[thread_count];
+    for (int i = 0; i < thread_count; ++i)
+    {
+        mpfr_init2(shared_results[i], working_prec);
+        mpfr_set_zero(shared_results[i], 1); // Positive zero
+    }
+
+    // Divide work
+    int terms_per_thread = max_terms / thread_count;
+    int leftover_terms = max_terms % thread_count;
+
+    std::vector<std::thread> threads;
+    int current_term = 0;
+
+    std::optional<TraceSpan> phase_span;
+    phase_span.emplace("series");
+
+    if(debug_level >= 2)
+    {
+        std::cout << "max_terms = " << max_terms << "\n";
+    }
+
+    // The worker instantiated for this debug level, so its loop carries no run time checks
+    auto worker = with_debug_level(debug_level, [](auto level) {
+        return &ChudnovskyTermCalculator::chudnovsky_worker<decltype(level)::value>;
+    });
+
+    for (int i = 0; i < thread_count; ++i)
+    {
+        int extra = (i < leftover_terms) ? 1 : 0;
+        int start = current_term;
+        int end = start + terms_per_thread + extra;
+
+        if (debug_level >= 2)
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cout << "[Thread " << i << "] k from " << start << " to " << (end - 1) << "\n";
+        }
+
+        threads.emplace_back(worker, std::ref(context), i, start, end, shared_results);
+        current_term = end;
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    phase_span.reset();
+
+    if (context.cancelled())
+    {
+        for (int i = 0; i < thread_count; ++i)
+            mpfr_clear(shared_results[i]);
+        delete[] shared_results;
+        return PiStatus::Cancelled; // Skip output and cleanup safely
+    }
+
+    // Display the shared_results
+    if (debug_level >=3 )
+    {
+        for (int i = 0; i < thread_count; ++i)
+        {
+            std::cerr << "[Main] shared_results[" << i << "] = ";
+            mpfr_out_str(stderr, 10, 100, shared_results[i], MPFR_RNDN);
+            std::cerr << "\n";
+        }
+    }
+
+//  Sum results
+    phase_span.emplace("merge");
+    mpfr_t total_sum;
+    mpfr_init2(total_sum, working_prec);
+    mpfr_set_zero(total_sum, 1);
+
+    if (placement_numa_enabled() && placement_node_count() > 1)
+    {
+        merge_partial_sums_by_node(total_sum, shared_results, thread_count, debug_level);
+        for (int i = 0; i < thread_count; ++i)
+            mpfr_clear(shared_results[i]);
+    }
+    else for (int i = 0; i < thread_count; ++i)
+    {
+        if (debug_level >= 3)
+        {
+            std::cerr << "[Main] shared_results[" << i << "] = ";
+            mpfr_out_str(stderr, 10, 80, shared_results[i], MPFR_RNDN);
+            std::cerr << "\n";
+        }
+
+        mpfr_add(total_sum, total_sum, shared_results[i], MPFR_RNDN);
+
+        if (debug_level >= 3)
+        {
+            std::cerr << "Accumulated total after thread[" << i << "] = ";
+            mpfr_out_str(stderr, 10, 80, total_sum, MPFR_RNDN);
+            std::cerr << "\n";
+        }
+
+        mpfr_clear(shared_results[i]);
+    }
+    delete[] shared_results;
+
+    // === CHUDNOVSKY CONSTANT C = 426880 * sqrt(10005) ===
+    mpfr_t C, sqrt_10005;
+    mpfr_init2(C, working_prec);
+    mpfr_init2(sqrt_10005, working_prec);
+
+    phase_span.reset();
+    phase_span.emplace("sqrt");
+    mpfr_sqrt_ui(sqrt_10005, ChudnovskyPi::SQRT_ARGUMENT, MPFR_RNDN);
+    mpfr_mul_ui(C, sqrt_10005, ChudnovskyPi::SCALE, MPFR_RNDN);
+
+    // === Final division: pi = C / sum ===
+    phase_span.reset();
+    phase_span.emplace("division");
+    mpfr_div(pi_approx, C, total_sum, MPFR_RNDN);
+    phase_span.reset();
+
+    mpfr_clear(total_sum);
+    mpfr_clear(C);
+    mpfr_clear(sqrt_10005);
+
+    // Optional verbose final output
+    if (debug_level >= 3)
+    {
+        mpfr_printf("Final computed pi = %.*Rf\n", static_cast<int>(decimal_places), pi_approx);
+    }
+    return PiStatus::Ok;
+}
+
+
+template <int DebugLevel>
+static void chudnovsky_worker_dynamic(
+    PiContext& context,
+    DynamicSchedule& schedule,
     int id, 
-    mpfr_t& local_sum, 
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
+    mpfr_t& local_sum)
 {
+    const PiOptions& options = context.options();
+    const mpfr_prec_t working_prec = context.precision();
+    constexpr int debug_level = DebugLevel;
+    const long long decimal_places = options.decimal_places;
+    const std::vector<std::string>& reference_terms = options.reference_terms;
+
+    // Pin first so the term and scratchpad limbs are first touched on this worker's node
+    placement_apply(id);
+
     mpfr_t term;
     mpfr_init2(term, working_prec);
     mpfr_set_ui(term, 0, MPFR_RNDN); 
     mpfr_set_ui(local_sum, 0, MPFR_RNDN);
 
-    ChudnovskyTermCalculator calculator(working_prec, debug_level);
+    ChudnovskyTermCalculator calculator(working_prec, debug_level, options.fingerprint_checks);
 
     ChudnovskyScratchpad scratch(working_prec);
 
-        while (!stop_requested) 
+    trace_set_thread_name("worker " + std::to_string(id));
+    TraceSpan worker_span("series", "worker");
+
+        while (!context.cancelled()) 
     {
         // int start_k = current_k.fetch_add(chunk_size);
         // if (start_k > max_k) break;
         // int end_k = std::min(start_k + chunk_size, max_k + 1);
 
-        int start_k = current_k.fetch_add(chunk_size);
-        int end_k = std::min(start_k + chunk_size, max_k + 1);
+        int start_k = schedule.current_k.fetch_add(schedule.chunk_size);
+        int end_k = std::min(start_k + schedule.chunk_size, schedule.max_k + 1);
         if (start_k >= end_k) 
         {
-            if (debug_level >= 2) 
+            if constexpr (debug_level >= 2) 
             {
                 std::lock_guard<std::mutex> lock(console_mutex);
                 std::cerr << "[chudnovsky_worker_dynamic] Thread " << id << " skipped: start_k=" << start_k << " >= end_k=" << end_k << "\n";
             }
             break;
         }
-        if (debug_level >= 2) 
+        TraceSpan chunk_span("chunk", "chunk", start_k);
+
+        if constexpr (debug_level >= 2) 
         {
             std::lock_guard<std::mutex> lock(console_mutex);
             std::cerr << "[chudnovsky_worker_dynamic] Thread " << id << " processing k from " << start_k << " to " << (end_k - 1) << "\n";
         }
 
-        if (debug_level >= 1)
+        if constexpr (debug_level >= 1)
         {
            std::lock_guard<std::mutex> lock(console_mutex);
            std::cerr << "[Thread " << id << "] Starting work from " << start_k << " to " << end_k -1 << "\n";
@@ -466,18 +721,23 @@ void chudnovsky_worker_dynamic(
         for (int k = start_k; k < end_k; ++k) 
         {
             compute_chudnovsky_term(term, k, scratch);
-            if (debug_level >= 2)
+            if constexpr (debug_level >= 3)
+            {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                mpfr_printf("[compute_chudnovsky_term] Term k=%ld: %.Re\n", static_cast<long>(k), term);
+            }
+            if constexpr (debug_level >= 2)
             {
                 calculator.compare_value("term", term, reference_terms, k, decimal_places);
             }
             mpfr_add(local_sum, local_sum, term, MPFR_RNDN);
 
             // Add one to the iteration counter for the monitoring thread.
-            iteration_counter.fetch_add(1, std::memory_order_relaxed);
+            context.add_progress(1);
         }
     }
 
-    if (debug_level >= 2) 
+    if constexpr (debug_level >= 2) 
     {
         std::lock_guard<std::mutex> lock(console_mutex);
         std::cerr << "[chudnovsky_worker_dynamic] Thread " << id << " storing result into partial_sums[" << id << "]\n";
@@ -489,23 +749,72 @@ void chudnovsky_worker_dynamic(
     mpfr_clear(term);
 }
 
-void calculate_pi_chudnovsky_dynamic(
-    int thread_count,
-    mpfr_t& pi_result,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
+// Each node's partial sums are added by a thread running on that node, so the big partial
+// sums are read locally and only one value per node crosses the interconnect.
+void merge_partial_sums_by_node(mpfr_t total, mpfr_t* partials, int count, int debug_level)
+{
+    std::vector<int> nodes;
+    for (int i = 0; i < count; ++i)
+    {
+        int node = placement_node_of_worker(i);
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end()) nodes.push_back(node);
+    }
 
+    mpfr_t* node_sums = new mpfr_t[nodes.size()];
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        threads.emplace_back([&, n]() {
+            placement_apply_node(nodes[n]);
+            trace_set_thread_name("merge node " + std::to_string(nodes[n]));
+            TraceSpan node_span("node merge", "worker", nodes[n]);
+
+            mpfr_init2(node_sums[n], mpfr_get_prec(total));
+            mpfr_set_zero(node_sums[n], 1);
+            for (int i = 0; i < count; ++i)
+            {
+                if (placement_node_of_worker(i) == nodes[n])
+                    mpfr_add(node_sums[n], node_sums[n], partials[i], MPFR_RNDN);
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        mpfr_add(total, total, node_sums[n], MPFR_RNDN);
+        mpfr_clear(node_sums[n]);
+    }
+    delete[] node_sums;
+
+    if (debug_level >= 2)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[merge_partial_sums_by_node] Merged " << count << " partial sums on " << nodes.size() << " nodes\n";
+    }
+}
+
+PiStatus calculate_pi_chudnovsky_dynamic(PiContext& context, mpfr_t pi_result)
 {
+    const PiOptions& options = context.options();
+    const mpfr_prec_t working_prec = context.precision();
+    const int debug_level = options.debug_level;
+    const long long decimal_places = options.decimal_places;
+    const int thread_count = options.threads;
+
+    DynamicSchedule schedule;
+    set_dynamic_chunks(schedule, options.chunk_size, decimal_places, debug_level);
+
     if (debug_level >= 2)
     {
         std::lock_guard<std::mutex> lock(console_mutex);
         std::cout << "[calculate_pi_chudnovsky_dynamic] working_prec = " << working_prec << " bits\n";
-        std::cout << "[calculate_pi_chudnovsky_dynamic] chunk_size = " << chunk_size << "\n";
+        std::cout << "[calculate_pi_chudnovsky_dynamic] chunk_size = " << schedule.chunk_size << "\n";
     }
 
     // Storage for iterations used in the monitoring thread.
-    iterations.store(max_k + 1, std::memory_order_relaxed);
-    iteration_counter.store(0, std::memory_order_relaxed);
+    context.set_progress_total(schedule.max_k + 1);
 
     // Allocate C-style array of mpfr_t
     mpfr_t* partial_sums = new mpfr_t[thread_count];
@@ -515,28 +824,48 @@ void calculate_pi_chudnovsky_dynamic(
         mpfr_init2(partial_sums[i], working_prec);
         mpfr_set_zero(partial_sums[i], 1); // Initialize to zero
     }
-    std::vector<std::thread> threads;
-    for (int i = 0; i < thread_count; ++i)
     {
-        threads.emplace_back(
-            chudnovsky_worker_dynamic, 
-            i, 
-            std::ref(partial_sums[i]), 
-            std::cref(reference_terms), 
-            std::cref(reference_sums)
-        ); 
+        TraceSpan series_span("series");
+        auto worker = with_debug_level(debug_level, [](auto level) {
+            return &chudnovsky_worker_dynamic<decltype(level)::value>;
+        });
+        std::vector<std::thread> threads;
+        for (int i = 0; i < thread_count; ++i)
+        {
+            threads.emplace_back(
+                worker, 
+                std::ref(context),
+                std::ref(schedule),
+                i, 
+                std::ref(partial_sums[i])
+            ); 
+        }
+
+        // Wait for threads to finish
+        for (auto& t : threads)
+            t.join();
     }
 
-    // Wait for threads to finish
-    for (auto& t : threads)
-        t.join();
+    if (context.cancelled())
+    {
+        for (int i = 0; i < thread_count; ++i)
+            mpfr_clear(partial_sums[i]);
+        delete[] partial_sums;
+        return PiStatus::Cancelled;
+    }
 
     // Combine partial results
+    std::optional<TraceSpan> phase_span;
+    phase_span.emplace("merge");
     mpfr_t sum;
     mpfr_init2(sum, working_prec);
     mpfr_set_ui(sum, 0, MPFR_RNDN);
 
-    for (int i = 0; i < thread_count; ++i) 
+    if (placement_numa_enabled() && placement_node_count() > 1)
+    {
+        merge_partial_sums_by_node(sum, partial_sums, thread_count, debug_level);
+    }
+    else for (int i = 0; i < thread_count; ++i) 
     {
         mpfr_add(sum, sum, partial_sums[i], MPFR_RNDN);
 
@@ -568,9 +897,15 @@ void calculate_pi_chudnovsky_dynamic(
     mpfr_init2(sqrt_c, working_prec);
     mpfr_init2(factor, working_prec);
 
-    mpfr_sqrt_ui(sqrt_c, 10005, MPFR_RNDN);
-    mpfr_mul_ui(factor, sqrt_c, 426880, MPFR_RNDN);
+    phase_span.reset();
+    phase_span.emplace("sqrt");
+    mpfr_sqrt_ui(sqrt_c, ChudnovskyPi::SQRT_ARGUMENT, MPFR_RNDN);
+    mpfr_mul_ui(factor, sqrt_c, ChudnovskyPi::SCALE, MPFR_RNDN);
+
+    phase_span.reset();
+    phase_span.emplace("division");
     mpfr_div(pi_result, factor, sum, MPFR_RNDN); // <-- write into caller's mpfr_t
+    phase_span.reset();
 
     mpfr_clear(sqrt_c);
     mpfr_clear(factor);
@@ -578,7 +913,7 @@ void calculate_pi_chudnovsky_dynamic(
     if (debug_level >= 3)
     {
         std::lock_guard<std::mutex> lock(console_mutex);
-        mpfr_printf("[Result] Computed pi: %.*Rf\n", decimal_places, pi_result);
+        mpfr_printf("[Result] Computed pi: %.*Rf\n", static_cast<int>(decimal_places), pi_result);
     }
 
     // Cleanup
@@ -587,28 +922,40 @@ void calculate_pi_chudnovsky_dynamic(
              mpfr_clear(partial_sums[i]);
     }
     delete[] partial_sums;
+    return PiStatus::Ok;
 }
 
 
-void ChudnovskyTermCalculator::calculate_chudnovsky_singlethreaded(
-    mpfr_t pi_approx,
-    mpfr_prec_t working_prec,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums)
+PiStatus ChudnovskyTermCalculator::calculate_chudnovsky_singlethreaded(PiContext& context, mpfr_t pi_approx)
+{
+    return with_debug_level(context.options().debug_level, [&](auto level) {
+        return calculate_chudnovsky_singlethreaded<decltype(level)::value>(context, pi_approx);
+    });
+}
+
+template <int DebugLevel>
+PiStatus ChudnovskyTermCalculator::calculate_chudnovsky_singlethreaded(PiContext& context, mpfr_t pi_approx)
 {
+    const PiOptions& options = context.options();
+    const mpfr_prec_t working_prec = context.precision();
+    constexpr int debug_level = DebugLevel;
+    const long long decimal_places = options.decimal_places;
+    const std::vector<std::string>& reference_terms = options.reference_terms;
+    const std::vector<std::string>& reference_sums = options.reference_sums;
+
     mpfr_t sum, sqrt_10005, C;
     mpfr_init2(sum, working_prec);
     mpfr_init2(sqrt_10005, working_prec);
     mpfr_init2(C, working_prec);
 
-    ChudnovskyTermCalculator calculator(working_prec, debug_level);
+    ChudnovskyTermCalculator calculator(working_prec, debug_level, options.fingerprint_checks);
 
     unsigned long k = 0;
     unsigned long max_terms = this->estimate_required_k(decimal_places);
 
-    iterations.store(max_terms, std::memory_order_relaxed);
+    context.set_progress_total(max_terms);
 
-    if (debug_level >= 3)
+    if constexpr (debug_level >= 3)
     {
         //printf("decimal_places = %d \n", decimal_places);
         std::cout << "decimal_places = " << decimal_places << "\n";
@@ -619,106 +966,133 @@ void ChudnovskyTermCalculator::calculate_chudnovsky_singlethreaded(
     mpfr_set_ui(sum, 0, MPFR_RNDN); // sum = 0
     ChudnovskyScratchpad scratch(working_prec);
 
+    std::optional<TraceSpan> phase_span;
+    std::optional<TraceSpan> chunk_span;
+    phase_span.emplace("series");
+
     while (k <= max_terms)
     {
-        auto start_k = std::chrono::high_resolution_clock::now();  // Only required for debug timing
+        if (k % options.chunk_size == 0)
+        {
+            chunk_span.reset();
+            chunk_span.emplace("chunk", "chunk", k);
+        }
 
-        if (stop_requested.load())
+        // Per term timing is only reported at debug level 3
+        std::chrono::high_resolution_clock::time_point start_k;
+        if constexpr (debug_level >= 3)
         {
-            std::cerr << "[Main] Interrupt detected. Exiting early...\n";
-            //break;
-            std::exit(1);
+            start_k = std::chrono::high_resolution_clock::now();
         }
 
-        iteration_counter.store(k, std::memory_order_relaxed);
+        if (context.cancelled())
+        {
+            if constexpr (debug_level >= 1)
+            {
+                std::cerr << "[Main] Interrupt detected. Exiting early...\n";
+            }
+            mpfr_clear(sum);
+            mpfr_clear(sqrt_10005);
+            mpfr_clear(C);
+            return PiStatus::Cancelled;
+        }
+
+        context.set_progress(k);
 
         mpfr_t term;
         mpfr_init2(term, working_prec);
         calculator.compute_term(term, k, scratch);
 
-        if (debug_level >= 3)
+        if constexpr (debug_level >= 3)
         {
             printf("Computed term:\n");
             mpfr_printf("k=%lu, term = %.100Rf\n", k, term);
         }
 
-        if (debug_level >= 3)
+        if constexpr (debug_level >= 3)
         {
-            this->compare_value("term", term, reference_terms, k, decimal_places);
+            calculator.compare_value("term", term, reference_terms, k, decimal_places);
         }
 
-        if (debug_level >= 3)
+        if constexpr (debug_level >= 3)
         {
             mpfr_printf("sum BEFORE add   k=%lu, sum=%.200Rf\n", k, sum);
         }
 
         mpfr_add(sum, sum, term, MPFR_RNDN);
 
-        if (debug_level >= 3)
+        if constexpr (debug_level >= 3)
         {
-            this->compare_value("sum", sum, reference_sums, k, decimal_places);
+            calculator.compare_value("sum", sum, reference_sums, k, decimal_places);
         }
 
         mpfr_clear(term);
         ++k;
 
-        auto end_k = std::chrono::high_resolution_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end_k - start_k);
-
-        if (debug_level >=3 )
+        if constexpr (debug_level >= 3)
         {
+            auto end_k = std::chrono::high_resolution_clock::now();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end_k - start_k);
             std::cout << "Time for k=" << k << ": " << elapsed.count() << " μs\n";
         }
 
-        if (debug_level >= 3)
+        if constexpr (debug_level >= 3)
         {
             printf("============================ Next k =================================\n");
         }
     }
 
-    if (debug_level >= 3)
+    chunk_span.reset();
+    phase_span.reset();
+
+    if constexpr (debug_level >= 3)
     {
         printf("=================== Compute Final Value of pi =======================\n");
     }
 
-    mpfr_set_str(C, "426880", 10, MPFR_RNDN);
-    mpfr_sqrt_ui(sqrt_10005, 10005, MPFR_RNDN);
+    phase_span.emplace("sqrt");
+    mpfr_set_ui(C, ChudnovskyPi::SCALE, MPFR_RNDN);
+    mpfr_sqrt_ui(sqrt_10005, ChudnovskyPi::SQRT_ARGUMENT, MPFR_RNDN);
 
-    if (debug_level >= 3)
+    if constexpr (debug_level >= 3)
     {
         mpfr_printf("(Expect~ 100.02499375) Computed sqrt_10005 = %.100Rf\n", sqrt_10005);
     }
 
     mpfr_mul(C, C, sqrt_10005, MPFR_RNDN);
 
-    if (debug_level >= 3)
+    if constexpr (debug_level >= 3)
     {
         mpfr_printf("(Expect~ 4268800.0) Computed C (426880 * sqrt_10005) = %.100Rf\n", C);
     }
 
     mpfr_set_prec(pi_approx, working_prec);
 
-    if (debug_level >= 2)
+    if constexpr (debug_level >= 2)
     {
         printf("C precision      = %lu\n", mpfr_get_prec(C));
         printf("sum precision    = %lu\n", mpfr_get_prec(sum));
         printf("pi_approx prec   = %lu\n", mpfr_get_prec(pi_approx));
     }
 
+    phase_span.reset();
+    phase_span.emplace("division");
     mpfr_div(pi_approx, C, sum, MPFR_RNDN);
+    phase_span.reset();
 
-    if (debug_level >= 3)
+    if constexpr (debug_level >= 3)
     {
         mpfr_printf("Computed sum = %.50Rf\n", sum);
     }
 
-    if (debug_level >= 2)
+    if constexpr (debug_level >= 2)
     {
-        mpfr_printf("Final computed pi_approx = %.*Rf\n", decimal_places, pi_approx);
+        mpfr_printf("Final computed pi_approx = %.*Rf\n", static_cast<int>(decimal_places), pi_approx);
     }
 
     mpfr_clear(sum);
     mpfr_clear(sqrt_10005);
     mpfr_clear(C);
+    return PiStatus::Ok;
 }
 
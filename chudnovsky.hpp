@@ -2,43 +2,95 @@
 #ifndef CHUDNOVSKY_HPP
 #define CHUDNOVSKY_HPP
 
+#include <cstdint>
 #include <mpfr.h>
 #include <vector>
 #include <string>
+#include "libpi.hpp"
+
+// Per-thread scratch values reused between terms to avoid repeated allocation
+struct ChudnovskyScratchpad {
+    mpfr_t term, num, den, k_mp, k3_mp;
+    mpz_t fact_k, fact_3k, fact_6k, pow_640320;
+
+    // temps for numerator/denominator construction
+    mpz_t tmp1, tmp2, tmp3, tmp4, tmp5;
+
+    unsigned long last_k;
+
+    ChudnovskyScratchpad(mpfr_prec_t working_prec) {
+        mpfr_init2(term, working_prec);
+        mpfr_init2(num, working_prec);
+        mpfr_init2(den, working_prec);
+        mpfr_init2(k_mp, working_prec);
+        mpfr_init2(k3_mp, working_prec);
+
+        //mpz_inits(fact_k, fact_3k, fact_6k, pow_640320, nullptr);
+        mpz_inits(fact_k, fact_3k, fact_6k, pow_640320,
+            tmp1, tmp2, tmp3, tmp4, tmp5,
+            nullptr);
+
+        last_k = 0;
+        mpz_fac_ui(fact_k, 0);
+        mpz_fac_ui(fact_3k, 0);
+        mpz_fac_ui(fact_6k, 0);
+        mpz_set_ui(pow_640320, 1);
+    }
+    ~ChudnovskyScratchpad() {
+        mpfr_clears(term, num, den, k_mp, k3_mp, (mpfr_ptr) 0);
+        mpz_clears(fact_k, fact_3k, fact_6k, pow_640320,
+            tmp1, tmp2, tmp3, tmp4, tmp5,
+            nullptr);
+    }
+};
+
+// A decimal value truncated to some number of places, as residues of the integer its digits
+// form (sign aside) modulo two 64-bit primes. Equal values give equal fingerprints; different
+// ones collide with probability about 2^-128.
+struct DecimalFingerprint {
+    uint64_t residue[2];
+    bool negative;
 
-// Forward declaration
-struct ChudnovskyScratchpad;
+    bool operator==(const DecimalFingerprint& other) const {
+        return residue[0] == other.residue[0] && residue[1] == other.residue[1] && negative == other.negative;
+    }
+};
 
 class ChudnovskyTermCalculator {
 public:
-    ChudnovskyTermCalculator(mpfr_prec_t precision, int debug_level);
+    // fingerprints: compare terms and sums with the reference by DecimalFingerprint, printing
+    // decimal strings only on a mismatch (false: always compare the strings)
+    ChudnovskyTermCalculator(mpfr_prec_t precision, int debug_level, bool fingerprints = true);
     ~ChudnovskyTermCalculator();
 
     //void compute_term(mpfr_t result, unsigned long k);
     void compute_term(mpfr_t result, unsigned long k, ChudnovskyScratchpad& scratch);
 
+    // Instantiated per debug level (see with_debug_level in globals.hpp)
+    template <int DebugLevel>
     static void chudnovsky_worker(
+        PiContext& context,
         int thread_id,
         int start_term,
         int end_term,
-        mpfr_t* shared_results,
-        mpfr_prec_t prec,
-        int debug_level,
-        const std::vector<std::string>& reference_terms,
-        const std::vector<std::string>& reference_sums);
+        mpfr_t* shared_results);
 
     static unsigned long estimate_required_k(long long decimal_places);
 
-    void calculate_chudnovsky_singlethreaded(mpfr_t pi_approx,
-                                             mpfr_prec_t working_prec,
-                                             const std::vector<std::string>& reference_terms,
-                                             const std::vector<std::string>& reference_sums);
+    PiStatus calculate_chudnovsky_singlethreaded(PiContext& context, mpfr_t pi_approx);
+    template <int DebugLevel>
+    PiStatus calculate_chudnovsky_singlethreaded(PiContext& context, mpfr_t pi_approx);
 
     void init_scratchpad_at_k(ChudnovskyScratchpad& scratch, unsigned long k);
 
     //void compare_value(const std::string& label, const mpfr_t value, const std::vector<std::string>& reference_values, int k, mpfr_prec_t working_prec);
-    void compare_value(const std::string& label, const mpfr_t value, const std::vector<std::string>& reference_values, int k, long long decimal_places);
-    void compare_strings_verbose(const std::string& label, const std::string& s1, const std::string& s2);
+    // True when value matches reference_values[k] (or there is none); mismatches are reported
+    bool compare_value(const std::string& label, const mpfr_t value, const std::vector<std::string>& reference_values, int k, long long decimal_places);
+    bool compare_strings_verbose(const std::string& label, const std::string& s1, const std::string& s2);
+
+    // Fingerprint of a decimal string ("-0.000255...") or a value, truncated to places decimals
+    static DecimalFingerprint fingerprint_decimal(const std::string& text, long long places);
+    DecimalFingerprint fingerprint_value(const mpfr_t value, long long places);
     void compute_chudnovsky_term(mpfr_t& term, long k, ChudnovskyScratchpad& scratch);
 
 
@@ -46,6 +98,11 @@ public:
 private:
     mpfr_prec_t prec;
     int debug;
+    bool fingerprints;
+
+    // 10^power_places for fingerprint_value, kept between calls
+    mpz_t power_of_ten;
+    long long power_places = -1;
 
     // Scratchpad variables
     mpfr_t mp_k, mp_3k, power_neg1;
@@ -55,7 +112,16 @@ private:
 };
 
 // ===== standalone helper function declarations =====
-void set_dynamic_chunks(int user_chunk_request);
+mpfr_prec_t get_chudnovsky_precision(long long decimal_places, int buffer = 20000);
+
+// Chudnovsky term calculation used by the dynamic workers
+void compute_chudnovsky_term(mpfr_t& term, long k, ChudnovskyScratchpad& scratch);
+
+// Add the workers' partial sums into total one NUMA node at a time (--numa)
+void merge_partial_sums_by_node(mpfr_t total, mpfr_t* partials, int count, int debug_level);
+
+// Static multithreaded Chudnovsky: fixed term ranges per thread
+PiStatus calculate_pi_multithreaded(PiContext& context, mpfr_t pi_approx);
 
 //void calculate_pi_chudnovsky_dynamic(int thread_count, mpfr_prec_t working_prec, mpfr_t& pi_result);
 //void calculate_pi_chudnovsky_dynamic(int thread_count, mpfr_t& pi_result);
@@ -64,12 +130,9 @@ void set_dynamic_chunks(int user_chunk_request);
 //    const std::vector<mpfr_t>& reference_terms,
 //    const std::vector<mpfr_t>& reference_sums);
 
-void calculate_pi_chudnovsky_dynamic(
-    int thread_count, 
-    mpfr_t& pi_result,
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums);
-    
+// Dynamic multithreaded Chudnovsky: threads fetch chunks of terms until none are left
+PiStatus calculate_pi_chudnovsky_dynamic(PiContext& context, mpfr_t pi_result);
+
 
 void calculate_pi_chudnovsky(int thread_count);
 
@@ -85,10 +148,4 @@ void calculate_pi_chudnovsky(int thread_count);
 //    const std::vector<mpfr_t>& reference_terms,
 //    const std::vector<mpfr_t>& reference_sums);
 
-void chudnovsky_worker_dynamic(
-    int id, 
-    mpfr_t& local_sum, 
-    const std::vector<std::string>& reference_terms,
-    const std::vector<std::string>& reference_sums);
-
 #endif
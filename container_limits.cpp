@@ -0,0 +1,300 @@
+#include "container_limits.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sched.h>
+
+namespace fs = std::filesystem;
+
+struct CgroupMount
+{
+    std::string mount_point;
+    std::string root;                   // Part of the hierarchy mounted there ("/" normally)
+    int version = 0;
+    std::vector<std::string> controllers;
+};
+
+// v1 limits at or above this are "unlimited" (the kernel reports LONG_MAX rounded to a page)
+static const long long V1_UNLIMITED = 1LL << 62;
+
+static std::vector<std::string> split(const std::string& text, char separator)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) parts.push_back(part);
+    return parts;
+}
+
+static std::string read_first_line(const fs::path& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Number in a cgroup file, -1 for "max", a missing file or anything unparsable
+static long long read_limit(const fs::path& path)
+{
+    std::string text = read_first_line(path);
+    if (text.empty() || text == "max") return -1;
+    try
+    {
+        return std::stoll(text);
+    }
+    catch (const std::exception&)
+    {
+        return -1;
+    }
+}
+
+static std::vector<CgroupMount> read_cgroup_mounts()
+{
+    std::vector<CgroupMount> mounts;
+    std::ifstream mountinfo("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(mountinfo, line))
+    {
+        // id parent major:minor root mount_point options [optional...] - fstype source super_options
+        size_t dash = line.find(" - ");
+        if (dash == std::string::npos) continue;
+        std::vector<std::string> before = split(line.substr(0, dash), ' ');
+        std::vector<std::string> after = split(line.substr(dash + 3), ' ');
+        if (before.size() < 5 || after.size() < 3) continue;
+
+        CgroupMount mount;
+        if (after[0] == "cgroup2")
+            mount.version = 2;
+        else if (after[0] == "cgroup")
+            mount.version = 1;
+        else
+            continue;
+
+        mount.root = before[3];
+        mount.mount_point = before[4];
+        if (mount.version == 1) mount.controllers = split(after[2], ',');
+        mounts.push_back(mount);
+    }
+    return mounts;
+}
+
+// Directory of our cgroup for a v1 controller, or the unified hierarchy when controller is empty
+static bool find_cgroup_dir(const std::vector<CgroupMount>& mounts, const std::string& controller,
+                            fs::path& dir, fs::path& mount_point)
+{
+    std::ifstream proc_cgroup("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(proc_cgroup, line))
+    {
+        // hierarchy-id:controller-list:path
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) continue;
+        std::vector<std::string> controllers = split(line.substr(first + 1, second - first - 1), ',');
+        std::string path = line.substr(second + 1);
+
+        bool wanted = controller.empty()
+            ? (line.compare(0, 3, "0::") == 0)
+            : std::find(controllers.begin(), controllers.end(), controller) != controllers.end();
+        if (!wanted) continue;
+
+        for (const auto& mount : mounts)
+        {
+            bool matches = controller.empty()
+                ? mount.version == 2
+                : mount.version == 1 && std::find(mount.controllers.begin(), mount.controllers.end(), controller) != mount.controllers.end();
+            if (!matches) continue;
+
+            // Strip the mounted root from our path; inside a cgroup namespace the path can
+            // also point above what is mounted, then the mount point itself is our cgroup
+            std::string relative = path;
+            if (mount.root != "/" && relative.compare(0, mount.root.size(), mount.root) == 0)
+                relative = relative.substr(mount.root.size());
+
+            mount_point = mount.mount_point;
+            dir = fs::path(mount.mount_point) / fs::path(relative).relative_path();
+            std::error_code ec;
+            if (!fs::is_directory(dir, ec)) dir = mount_point;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Visit dir and each parent up to the mount point
+template <typename Visit>
+static void for_each_level(fs::path dir, const fs::path& mount_point, Visit visit)
+{
+    while (true)
+    {
+        visit(dir);
+        if (dir == mount_point || !dir.has_parent_path() || dir.parent_path() == dir) break;
+        if (dir.string().size() <= mount_point.string().size()) break;
+        dir = dir.parent_path();
+    }
+}
+
+static std::string memory_usage_file;
+
+static ContainerLimits detect_limits()
+{
+    ContainerLimits limits;
+    limits.host_cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    limits.affinity_cpus = limits.host_cpus;
+
+    // The affinity mask already reflects the cpuset (cpuset.cpus / cpuset.cpus.effective)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        limits.affinity_cpus = std::max(1, CPU_COUNT(&allowed));
+    }
+
+    std::vector<CgroupMount> mounts = read_cgroup_mounts();
+    fs::path dir, mount_point;
+
+    // CPU quota: the tightest level wins
+    if (find_cgroup_dir(mounts, "cpu", dir, mount_point))
+    {
+        for_each_level(dir, mount_point, [&](const fs::path& level) {
+            long long quota = read_limit(level / "cpu.cfs_quota_us");
+            long long period = read_limit(level / "cpu.cfs_period_us");
+            if (quota > 0 && period > 0)
+            {
+                double cpus = static_cast<double>(quota) / period;
+                if (limits.cpu_quota < 0 || cpus < limits.cpu_quota) limits.cpu_quota = cpus;
+                limits.cgroup_version = 1;
+            }
+        });
+    }
+    else if (find_cgroup_dir(mounts, "", dir, mount_point))
+    {
+        for_each_level(dir, mount_point, [&](const fs::path& level) {
+            // cpu.max is "<quota|max> <period>"
+            std::vector<std::string> fields = split(read_first_line(level / "cpu.max"), ' ');
+            if (fields.size() == 2 && fields[0] != "max")
+            {
+                try
+                {
+                    double cpus = std::stod(fields[0]) / std::stod(fields[1]);
+                    if (limits.cpu_quota < 0 || cpus < limits.cpu_quota) limits.cpu_quota = cpus;
+                    limits.cgroup_version = 2;
+                }
+                catch (const std::exception&)
+                {
+                }
+            }
+        });
+    }
+
+    // Memory limit, remembering which level's usage counter to watch
+    bool have_v1_memory = find_cgroup_dir(mounts, "memory", dir, mount_point);
+    if (have_v1_memory || find_cgroup_dir(mounts, "", dir, mount_point))
+    {
+        const char* limit_file = have_v1_memory ? "memory.limit_in_bytes" : "memory.max";
+        const char* usage_file = have_v1_memory ? "memory.usage_in_bytes" : "memory.current";
+        limits.cgroup_path = dir.string();
+
+        for_each_level(dir, mount_point, [&](const fs::path& level) {
+            long long limit = read_limit(level / limit_file);
+            if (limit <= 0 || limit >= V1_UNLIMITED) return;
+            if (limits.memory_limit_bytes < 0 || limit < limits.memory_limit_bytes)
+            {
+                limits.memory_limit_bytes = limit;
+                limits.memory_usage_bytes = read_limit(level / usage_file);
+                memory_usage_file = (level / usage_file).string();
+                if (limits.cgroup_version == 0) limits.cgroup_version = have_v1_memory ? 1 : 2;
+            }
+        });
+    }
+
+    limits.effective_cpus = std::min(limits.host_cpus, limits.affinity_cpus);
+    if (limits.cpu_quota > 0)
+    {
+        limits.effective_cpus = std::min(limits.effective_cpus, static_cast<int>(std::ceil(limits.cpu_quota)));
+    }
+    limits.effective_cpus = std::max(1, limits.effective_cpus);
+    return limits;
+}
+
+const ContainerLimits& container_limits()
+{
+    static const ContainerLimits limits = detect_limits();
+    return limits;
+}
+
+std::string container_memory_usage_path()
+{
+    container_limits();
+    return memory_usage_file;
+}
+
+long long container_available_memory_bytes()
+{
+    long long available = -1;
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    long long value_kb;
+    while (meminfo >> key >> value_kb)
+    {
+        if (key == "MemAvailable:")
+        {
+            available = value_kb * 1024;
+            break;
+        }
+        meminfo.ignore(256, '\n');
+    }
+
+    const ContainerLimits& limits = container_limits();
+    if (limits.memory_limit_bytes > 0)
+    {
+        // Usage includes page cache the kernel could reclaim, so this errs on the safe side
+        long long usage = read_limit(memory_usage_file);
+        long long headroom = limits.memory_limit_bytes - std::max(0LL, usage);
+        available = (available < 0) ? headroom : std::min(available, headroom);
+    }
+    return available;
+}
+
+static std::string format_gib(long long bytes)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f GiB", bytes / (1024.0 * 1024.0 * 1024.0));
+    return text;
+}
+
+std::string describe_container_limits()
+{
+    const ContainerLimits& limits = container_limits();
+    std::ostringstream out;
+
+    out << limits.effective_cpus << " usable CPUs (" << limits.host_cpus << " on host";
+    if (limits.affinity_cpus < limits.host_cpus) out << ", " << limits.affinity_cpus << " in cpuset/affinity mask";
+    if (limits.cpu_quota > 0)
+    {
+        char quota[32];
+        std::snprintf(quota, sizeof(quota), "%.2f", limits.cpu_quota);
+        out << ", CPU quota " << quota;
+    }
+    out << ")";
+
+    if (limits.memory_limit_bytes > 0)
+    {
+        out << ", memory limit " << format_gib(limits.memory_limit_bytes);
+        if (limits.memory_usage_bytes >= 0) out << " (" << format_gib(limits.memory_usage_bytes) << " used)";
+    }
+    else
+    {
+        out << ", no memory limit";
+    }
+
+    if (limits.cgroup_version > 0) out << " [cgroup v" << limits.cgroup_version << "]";
+    return out.str();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef CONTAINER_LIMITS_HPP
+#define CONTAINER_LIMITS_HPP
+
+#include <string>
+
+// CPU and memory limits of the cgroup this process runs in (cgroup v1 and v2).
+//
+// Inside a container std::thread::hardware_concurrency() and /proc/meminfo describe the
+// host, not the pod. The limits here come from the cgroup files instead: cpu.max or
+// cpu.cfs_quota_us/cpu.cfs_period_us for a CPU quota, the cpuset and sched_getaffinity for
+// the CPUs we may run on, and memory.max or memory.limit_in_bytes for memory. Each level
+// from our cgroup up to the mount root is checked, since a parent limit applies too.
+
+struct ContainerLimits
+{
+    int cgroup_version = 0;             // 1 or 2 for the hierarchy the limits came from, 0 if none found
+    int host_cpus = 0;                  // std::thread::hardware_concurrency()
+    int affinity_cpus = 0;              // CPUs in the affinity mask (taskset, cpuset)
+    double cpu_quota = -1.0;            // CPUs worth of quota, -1 when unlimited
+    int effective_cpus = 0;             // What we can actually use: min of the above, at least 1
+    long long memory_limit_bytes = -1;  // -1 when unlimited
+    long long memory_usage_bytes = -1;  // Current cgroup usage, -1 when unknown
+    std::string cgroup_path;            // Memory (or unified) cgroup of this process
+};
+
+// Read the limits once and cache them; later calls return the cached values
+const ContainerLimits& container_limits();
+
+// Bytes still available: MemAvailable, capped by the cgroup headroom (limit - current usage)
+long long container_available_memory_bytes();
+
+// Path of the cgroup memory usage file (memory.current or memory.usage_in_bytes), for the
+// monitoring thread. Empty when the process is not under a memory limit.
+std::string container_memory_usage_path();
+
+// One line description for the startup banner
+std::string describe_container_limits();
+
+#endif
@@ -0,0 +1,353 @@
+#include "digit_index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr uint64_t GROUP_POSITIONS = 1ULL << 25;    // Raw positions held at once while building (256 MB)
+constexpr uint64_t COUNT_BYTES = 256ULL << 20;      // Per thread count tables together (40 MB each at K = 7)
+
+uint64_t power_of_ten(int exponent)
+{
+    uint64_t value = 1;
+    while (exponent-- > 0) value *= 10;
+    return value;
+}
+
+// K: about a hundred occurrences per string, 3 to 7 digits (an offset table of 80 MB at most)
+int gram_for(uint64_t count)
+{
+    int gram = 3;
+    while (gram < 7 && power_of_ten(gram + 3) <= count) ++gram;
+    return gram;
+}
+
+// Call f(position, value) for the K digit strings starting at positions [begin, end)
+template <typename F>
+void scan_grams(const char* digits, uint64_t begin, uint64_t end, int gram, F f)
+{
+    if (begin >= end) return;
+    const uint64_t high = power_of_ten(gram - 1);
+    uint64_t value = 0;
+    for (int i = 0; i < gram; ++i) value = value * 10 + (digits[begin + i] - '0');
+    f(begin, value);
+    for (uint64_t p = begin + 1; p < end; ++p)
+    {
+        value = (value - (digits[p - 1] - '0') * high) * 10 + (digits[p + gram - 1] - '0');
+        f(p, value);
+    }
+}
+
+template <typename F>
+void run_parallel(int threads, F f)
+{
+    if (threads == 1)
+    {
+        f(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) workers.emplace_back(f, t);
+    for (auto& worker : workers) worker.join();
+}
+
+void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t get_varint(const unsigned char*& p)
+{
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        unsigned char byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+}
+
+bool text_stamp(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+// A whole file mapped read only
+struct MappedFile
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const std::string& path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        data = static_cast<const char*>(mapped);
+        size = info.st_size;
+        return true;
+    }
+
+    void close()
+    {
+        if (data) munmap(const_cast<char*>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+
+    ~MappedFile() { close(); }
+};
+
+} // namespace
+
+std::string digit_index_path(const std::string& text_path)
+{
+    return text_path + ".idx";
+}
+
+bool build_digit_index(const char* digits, uint64_t count, const std::string& text_path, int threads, int debug_level)
+{
+    DigitIndexHeader header = {};
+    header.magic = DIGIT_INDEX_MAGIC;
+    header.version = DIGIT_INDEX_VERSION;
+    header.digits = count;
+    if (!text_stamp(text_path, header.text_size, header.text_mtime_ns)) return false;
+
+    const int gram = gram_for(count);
+    header.gram = gram;
+    const uint64_t lists = power_of_ten(gram);
+    const uint64_t starts = (count >= static_cast<uint64_t>(gram)) ? count - gram + 1 : 0;
+
+    // Chunks of start positions, each under 2^32 so the per chunk counts fit 32 bits. Every
+    // chunk has a count per string, so wide hosts get fewer chunks than threads to stay
+    // within COUNT_BYTES.
+    const uint64_t memory_threads = std::max<uint64_t>(1, COUNT_BYTES / (lists * sizeof(uint32_t)));
+    threads = static_cast<int>(std::max<uint64_t>({1, std::min<uint64_t>({static_cast<uint64_t>(threads), starts / 65536,
+                                                                          memory_threads}),
+                                                   (starts >> 32) + 1}));
+    std::vector<uint64_t> bounds(threads + 1);
+    for (int t = 0; t <= threads; ++t) bounds[t] = starts * t / threads;
+
+    if (debug_level >= 1)
+    {
+        std::cerr << "[Index] " << count << " digits, " << gram << " digit strings, " << threads << " threads\n";
+    }
+
+    // Pass 1: occurrences of every string in every chunk
+    std::vector<std::vector<uint32_t>> slots(threads, std::vector<uint32_t>(lists, 0));
+    run_parallel(threads, [&](int t) {
+        std::vector<uint32_t>& counts = slots[t];
+        scan_grams(digits, bounds[t], bounds[t + 1], gram, [&](uint64_t, uint64_t g) { ++counts[g]; });
+    });
+
+    std::string index_path = digit_index_path(text_path);
+    std::string temporary = index_path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+
+    std::vector<uint64_t> offsets(lists + 1, 0);
+    const off_t postings_start = static_cast<off_t>(sizeof(header) + offsets.size() * sizeof(uint64_t));
+    bool ok = (fseeko(file, postings_start, SEEK_SET) == 0);
+
+    // Pass 2, a group of strings at a time: each chunk drops its positions into place, which
+    // leaves every list sorted, then the lists are delta coded in parallel and appended
+    std::vector<uint64_t> positions;
+    std::vector<uint64_t> list_bytes;
+    std::vector<std::string> encoded(threads);
+    uint64_t written = 0;
+    for (uint64_t g0 = 0; ok && g0 < lists;)
+    {
+        uint64_t g1 = g0;
+        uint64_t total = 0;
+        std::vector<uint64_t> list_start;
+        while (g1 < lists)
+        {
+            uint64_t occurrences = 0;
+            for (int t = 0; t < threads; ++t) occurrences += slots[t][g1];
+            if (g1 > g0 && total + occurrences > GROUP_POSITIONS) break;
+            list_start.push_back(total);
+            for (int t = 0; t < threads; ++t)
+            {
+                uint32_t n = slots[t][g1];
+                slots[t][g1] = static_cast<uint32_t>(total);
+                total += n;
+            }
+            ++g1;
+        }
+        list_start.push_back(total);
+
+        positions.resize(total);
+        run_parallel(threads, [&](int t) {
+            std::vector<uint32_t>& slot = slots[t];
+            scan_grams(digits, bounds[t], bounds[t + 1], gram, [&](uint64_t p, uint64_t g) {
+                if (g >= g0 && g < g1) positions[slot[g]++] = p;
+            });
+        });
+
+        list_bytes.assign(g1 - g0, 0);
+        run_parallel(threads, [&](int t) {
+            std::string& out = encoded[t];
+            out.clear();
+            uint64_t first = (g1 - g0) * t / threads, last = (g1 - g0) * (t + 1) / threads;
+            for (uint64_t i = first; i < last; ++i)
+            {
+                size_t before = out.size();
+                uint64_t previous = 0;
+                for (uint64_t j = list_start[i]; j < list_start[i + 1]; ++j)
+                {
+                    put_varint(out, positions[j] - previous);
+                    previous = positions[j];
+                }
+                list_bytes[i] = out.size() - before;
+            }
+        });
+
+        for (uint64_t g = g0; g < g1; ++g)
+        {
+            offsets[g] = written;
+            written += list_bytes[g - g0];
+        }
+        for (const std::string& out : encoded)
+        {
+            ok = ok && std::fwrite(out.data(), 1, out.size(), file) == out.size();
+        }
+        g0 = g1;
+    }
+    offsets[lists] = written;
+
+    ok = ok && fseeko(file, 0, SEEK_SET) == 0 &&
+         std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+         std::fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(temporary.c_str(), index_path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    if (debug_level >= 1)
+    {
+        std::cerr << "[Index] " << index_path << ": " << (postings_start + written) / (1024 * 1024) << " MB\n";
+    }
+    return true;
+}
+
+long long find_in_digits(const std::string& text_path, const std::string& query, int threads, int debug_level)
+{
+    MappedFile text;
+    if (!text.open(text_path) || text.size < 3 || text.data[0] != '3' || text.data[1] != '.')
+    {
+        std::cerr << "[Error] " << text_path << " is not a computed digits file.\n";
+        return -1;
+    }
+    const char* digits = text.data + 2;
+    uint64_t count = text.size - 2;
+    while (count > 0 && (digits[count - 1] == '\n' || digits[count - 1] == '\r')) --count;
+
+    // The index, (re)built when missing or older than the digits
+    std::string index_path = digit_index_path(text_path);
+    MappedFile index;
+    auto usable = [&]() {
+        if (!index.open(index_path) || index.size < sizeof(DigitIndexHeader)) return false;
+        const DigitIndexHeader* header = reinterpret_cast<const DigitIndexHeader*>(index.data);
+        uint64_t text_size;
+        int64_t text_mtime;
+        if (header->magic != DIGIT_INDEX_MAGIC || header->version != DIGIT_INDEX_VERSION ||
+            header->gram < 3 || header->gram > 7 || header->digits != count ||
+            !text_stamp(text_path, text_size, text_mtime) ||
+            header->text_size != text_size || header->text_mtime_ns != text_mtime)
+            return false;
+        uint64_t table_end = sizeof(DigitIndexHeader) + (power_of_ten(header->gram) + 1) * sizeof(uint64_t);
+        if (index.size < table_end) return false;
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(index.data + sizeof(DigitIndexHeader));
+        return index.size == table_end + offsets[power_of_ten(header->gram)];
+    };
+    if (!usable())
+    {
+        if (!std::all_of(digits, digits + count, [](char c) { return c >= '0' && c <= '9'; }))
+        {
+            std::cerr << "[Error] " << text_path << " holds characters other than decimal digits.\n";
+            return -1;
+        }
+        std::cerr << "[Index] Building " << index_path << "\n";
+        if (!build_digit_index(digits, count, text_path, threads, debug_level) || !usable())
+        {
+            std::cerr << "[Error] Could not build " << index_path << "\n";
+            return -1;
+        }
+    }
+
+    const DigitIndexHeader* header = reinterpret_cast<const DigitIndexHeader*>(index.data);
+    const int gram = static_cast<int>(header->gram);
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(index.data + sizeof(DigitIndexHeader));
+    const unsigned char* postings = reinterpret_cast<const unsigned char*>(offsets + power_of_ten(gram) + 1);
+    const uint64_t length = query.size();
+
+    uint64_t key = 0;
+    for (int i = 0; i < std::min<int>(gram, static_cast<int>(length)); ++i) key = key * 10 + (query[i] - '0');
+
+    // At least K digits: the candidates are the list of the first K, in increasing order
+    if (length >= static_cast<uint64_t>(gram))
+    {
+        const unsigned char* p = postings + offsets[key];
+        const unsigned char* end = postings + offsets[key + 1];
+        uint64_t position = 0;
+        while (p < end)
+        {
+            position += get_varint(p);
+            if (position + length > count) break;
+            if (std::memcmp(digits + position, query.data(), length) == 0) return static_cast<long long>(position) + 1;
+        }
+        return 0;
+    }
+
+    // Shorter: the earliest first entry among the lists it prefixes, and the last K - 1 digits,
+    // where no K digit string starts, by a plain scan
+    uint64_t best = UINT64_MAX;
+    uint64_t span = power_of_ten(gram - static_cast<int>(length));
+    for (uint64_t g = key * span; g < (key + 1) * span; ++g)
+    {
+        if (offsets[g] == offsets[g + 1]) continue;
+        const unsigned char* p = postings + offsets[g];
+        best = std::min(best, get_varint(p));
+    }
+    uint64_t tail = (count >= static_cast<uint64_t>(gram)) ? count - gram + 1 : 0;
+    for (uint64_t position = tail; best == UINT64_MAX && position + length <= count; ++position)
+    {
+        if (std::memcmp(digits + position, query.data(), length) == 0) best = position;
+    }
+    return (best == UINT64_MAX) ? 0 : static_cast<long long>(best) + 1;
+}
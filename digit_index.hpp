@@ -0,0 +1,45 @@
+#pragma once
+#ifndef DIGIT_INDEX_HPP
+#define DIGIT_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+
+// Digit string search over a computed "3.14159..." file (--index, --find).
+//
+// The index, <file>.idx next to the digits, lists for every K digit string (K from 3 to 7,
+// chosen so each string occurs about a hundred times) the positions where it starts, as
+// delta-coded varints. A search for a string of K digits or more reads the list of its first
+// K digits and checks the candidates in order against the memory-mapped digits; a shorter one
+// takes the first entry of every list it prefixes. Either way only a few hundred positions
+// are touched, so billion-digit files answer in milliseconds.
+//
+// Layout: DigitIndexHeader, 10^K + 1 uint64_t byte offsets into the postings (list g is
+// [offset[g], offset[g + 1])), then the postings. Positions count from 0 at the first digit
+// after "3.".
+
+constexpr uint32_t DIGIT_INDEX_MAGIC = 0x58444950;          // "PIDX" on little endian hosts
+constexpr uint32_t DIGIT_INDEX_VERSION = 1;
+
+struct DigitIndexHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t gram;              // K
+    uint32_t reserved;
+    uint64_t digits;            // Decimal places indexed
+    uint64_t text_size;         // Size and modification time of the digits file, to spot a stale index
+    int64_t text_mtime_ns;
+};
+
+std::string digit_index_path(const std::string& text_path);
+
+// Index count digits (the decimal places, without "3.") that text_path holds, using up to
+// threads threads. The digits file must be complete, its size and time go in the header.
+bool build_digit_index(const char* digits, uint64_t count, const std::string& text_path, int threads, int debug_level);
+
+// Decimal place (1 = the first digit after "3.") where query first starts in text_path, 0 when
+// it does not occur, -1 on error. Builds the index first when it is missing or stale.
+long long find_in_digits(const std::string& text_path, const std::string& query, int threads, int debug_level);
+
+#endif
@@ -0,0 +1,502 @@
+#include "digit_server.hpp"
+#include "globals.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::atomic<bool> server_stop(false);
+static std::atomic<PiContext*> running_context(nullptr);
+
+static void server_signal_handler(int)
+{
+    server_stop.store(true);
+    PiContext* context = running_context.load();
+    if (context) context->cancel();
+}
+
+// A read only mapping of a "3.14159..." digits file
+struct DigitMapping
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    long long digits = 0;               // Decimal places held
+
+    bool open(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < 3)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);                    // The mapping keeps the file alive
+        if (mapped == MAP_FAILED) return false;
+
+        const char* text = static_cast<const char*>(mapped);
+        size_t length = info.st_size;
+        while (length > 2 && (text[length - 1] == '\n' || text[length - 1] == '\r')) --length;
+        if (text[0] != '3' || text[1] != '.')
+        {
+            munmap(mapped, info.st_size);
+            return false;
+        }
+
+        // Ranges are sent from here for as long as the daemon runs, so keep the pages resident
+        madvise(mapped, info.st_size, MADV_WILLNEED);
+
+        close();
+        data = text;
+        size = info.st_size;
+        digits = static_cast<long long>(length) - 2;
+        return true;
+    }
+
+    void close()
+    {
+        if (data) munmap(const_cast<char*>(data), size);
+        data = nullptr;
+        size = 0;
+        digits = 0;
+    }
+};
+
+struct ServerClient
+{
+    int fd = -1;
+    DigitRequest request{};
+    size_t received = 0;                // Bytes of request read so far
+    bool waiting = false;               // Parked until a computation covers the request
+    bool closing = false;               // A reply could not be sent, drop the connection
+
+    // Reply still going out, sent on POLLOUT; the digits are kept as an offset into the
+    // mapping, which is replaced when a computation publishes more
+    DigitReply reply{};
+    uint64_t payload_offset = 0;
+    uint64_t payload_size = 0;
+    uint64_t reply_sent = 0;            // Bytes of header and digits written so far
+    bool replying = false;
+};
+
+class DigitServer
+{
+public:
+    explicit DigitServer(const DigitServerConfig& config) : config(config)
+    {
+        max_digits = config.max_digits > 0 ? std::max(config.max_digits, config.initial_digits)
+                                           : config.initial_digits * 100;
+    }
+
+    ~DigitServer()
+    {
+        if (worker.joinable())
+        {
+            PiContext* context = running_context.load();
+            if (context) context->cancel();
+            worker.join();
+        }
+        for (auto& client : clients) ::close(client.fd);
+        if (listen_fd >= 0)
+        {
+            ::close(listen_fd);
+            unlink(config.socket_path.c_str());
+        }
+        if (wake_pipe[0] >= 0) ::close(wake_pipe[0]);
+        if (wake_pipe[1] >= 0) ::close(wake_pipe[1]);
+        mapping.close();
+    }
+
+    int run();
+
+private:
+    const DigitServerConfig& config;
+    long long max_digits = 0;
+    DigitMapping mapping;
+    int listen_fd = -1;
+    int wake_pipe[2] = {-1, -1};
+    std::vector<ServerClient> clients;
+
+    std::thread worker;
+    long long computing_digits = 0;     // Target of the running computation, 0 when idle
+    long long wanted_digits = 0;        // Largest target asked for while it ran
+    PiStatus worker_status = PiStatus::Ok;
+
+    bool open_socket();
+    bool compute_and_publish(long long digits);
+    void start_computation(long long digits);
+    void finish_computation();
+    void handle_request(ServerClient& client);
+    void queue_reply(ServerClient& client, DigitReplyStatus status, uint64_t first, uint64_t count,
+                     uint64_t payload_offset = 0);
+    bool send_reply(ServerClient& client);
+    void drop_client(size_t index);
+};
+
+bool DigitServer::open_socket()
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (config.socket_path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "[Error] Socket path too long: " << config.socket_path << "\n";
+        return false;
+    }
+    std::strncpy(address.sun_path, config.socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+    {
+        std::perror("[Error] socket");
+        return false;
+    }
+
+    // A socket file left behind by a previous daemon would make bind fail
+    unlink(config.socket_path.c_str());
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, 64) != 0)
+    {
+        std::perror("[Error] bind/listen");
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// Compute digits decimal places and replace the digits file (write to .tmp, then rename, so the
+// old file stays valid and mapped until the new one is complete). Runs on the worker thread.
+bool DigitServer::compute_and_publish(long long digits)
+{
+    PiOptions options = config.compute_options;
+    options.decimal_places = digits;
+    PiContext context(std::move(options));
+    running_context.store(&context);
+    if (server_stop.load()) context.cancel();
+
+    std::vector<char> buffer(PiContext::required_buffer_size(digits));
+    worker_status = context.compute(buffer.data(), buffer.size());
+    running_context.store(nullptr);
+    if (worker_status != PiStatus::Ok) return false;
+
+    std::string temporary = config.digits_path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "w");
+    if (!file)
+    {
+        worker_status = PiStatus::Error;
+        return false;
+    }
+    size_t length = static_cast<size_t>(digits) + 2;
+    bool written = std::fwrite(buffer.data(), 1, length, file) == length && std::fputc('\n', file) != EOF;
+    written = (std::fclose(file) == 0) && written;
+    if (!written || std::rename(temporary.c_str(), config.digits_path.c_str()) != 0)
+    {
+        unlink(temporary.c_str());
+        worker_status = PiStatus::Error;
+        return false;
+    }
+    return true;
+}
+
+void DigitServer::start_computation(long long digits)
+{
+    if (computing_digits > 0)
+    {
+        wanted_digits = std::max(wanted_digits, digits);
+        return;
+    }
+
+    computing_digits = digits;
+    wanted_digits = 0;
+    if (debug_level >= 1)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Server] Extending to " << digits << " decimal places\n";
+    }
+
+    worker = std::thread([this, digits]() {
+        // Leave SIGINT/SIGTERM to the serving thread so they interrupt its poll; the engine
+        // threads started from here inherit the mask
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        compute_and_publish(digits);
+        char done = 1;
+        while (write(wake_pipe[1], &done, 1) < 0 && errno == EINTR) {}
+    });
+}
+
+// Called on the serving thread once the worker has signalled: remap and answer parked clients
+void DigitServer::finish_computation()
+{
+    worker.join();
+    long long target = computing_digits;
+    computing_digits = 0;
+
+    bool ok = worker_status == PiStatus::Ok;
+    if (ok)
+    {
+        // The old mapping stays valid until now; nothing else reads it on this thread
+        DigitMapping updated;
+        ok = updated.open(config.digits_path);
+        if (ok)
+        {
+            mapping.close();
+            mapping = updated;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        if (ok)
+            std::cerr << "[Server] Now holding " << mapping.digits << " decimal places\n";
+        else
+            std::cerr << "[Error] Computing " << target << " decimal places failed: " << pi_status_string(worker_status) << "\n";
+    }
+
+    for (size_t i = 0; i < clients.size(); ++i)
+    {
+        ServerClient& client = clients[i];
+        if (!client.waiting) continue;
+        uint64_t last = client.request.first + client.request.count - 1;
+
+        if (last <= static_cast<uint64_t>(mapping.digits) || wanted_digits == 0)
+        {
+            client.waiting = false;
+            if (last <= static_cast<uint64_t>(mapping.digits))
+                handle_request(client);
+            else
+                queue_reply(client, DIGIT_FAILED, client.request.first, 0);
+        }
+    }
+
+    // Requests that arrived while computing asked for more than that run produced
+    if (wanted_digits > mapping.digits && !server_stop.load())
+    {
+        start_computation(wanted_digits);
+    }
+}
+
+void DigitServer::queue_reply(ServerClient& client, DigitReplyStatus status, uint64_t first, uint64_t count,
+                              uint64_t payload_offset)
+{
+    client.reply = DigitReply{DIGIT_PROTOCOL_MAGIC, status, first, count};
+    client.payload_offset = payload_offset;
+    client.payload_size = payload_offset ? count : 0;
+    client.reply_sent = 0;
+    client.replying = true;
+    if (!send_reply(client)) client.closing = true;
+}
+
+// Write as much of the pending reply as the socket takes without blocking. False when the
+// connection failed; the reply stays pending until it is all sent.
+bool DigitServer::send_reply(ServerClient& client)
+{
+    while (client.replying)
+    {
+        // Header and digits in one writev; the digits go from the page cache straight to the socket
+        iovec parts[2];
+        int count = 0;
+        uint64_t sent_digits = 0;
+        if (client.reply_sent < sizeof(DigitReply))
+        {
+            parts[count].iov_base = reinterpret_cast<char*>(&client.reply) + client.reply_sent;
+            parts[count].iov_len = sizeof(DigitReply) - client.reply_sent;
+            ++count;
+        }
+        else
+        {
+            sent_digits = client.reply_sent - sizeof(DigitReply);
+        }
+        if (sent_digits < client.payload_size)
+        {
+            parts[count].iov_base = const_cast<char*>(mapping.data + client.payload_offset + sent_digits);
+            parts[count].iov_len = client.payload_size - sent_digits;
+            ++count;
+        }
+
+        ssize_t sent = writev(client.fd, parts, count);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client.reply_sent += sent;
+        if (client.reply_sent == sizeof(DigitReply) + client.payload_size) client.replying = false;
+    }
+    return true;
+}
+
+void DigitServer::handle_request(ServerClient& client)
+{
+    const DigitRequest& request = client.request;
+    client.received = 0;
+
+    if (request.magic != DIGIT_PROTOCOL_MAGIC)
+    {
+        queue_reply(client, DIGIT_BAD_REQUEST, request.first, 0);
+    }
+    else if (request.op == DIGIT_OP_STATUS)
+    {
+        queue_reply(client, DIGIT_OK, mapping.digits, computing_digits);
+    }
+    else if (request.op != DIGIT_OP_RANGE || request.first == 0 || request.count == 0 ||
+             request.count > DIGIT_MAX_RANGE)
+    {
+        queue_reply(client, DIGIT_BAD_REQUEST, request.first, 0);
+    }
+    else
+    {
+        // A first past the limit is checked on its own, first + count could wrap around
+        uint64_t last = request.first + request.count - 1;
+        if (request.first <= static_cast<uint64_t>(mapping.digits) && last <= static_cast<uint64_t>(mapping.digits))
+        {
+            // Decimal place n is at offset n + 1 of "3.14159..."
+            queue_reply(client, DIGIT_OK, request.first, request.count, request.first + 1);
+        }
+        else if (request.first > static_cast<uint64_t>(max_digits) || last > static_cast<uint64_t>(max_digits))
+        {
+            queue_reply(client, DIGIT_TOO_LARGE, request.first, 0);
+        }
+        else
+        {
+            // Grow geometrically so a client walking forward does not trigger a run per request
+            long long target = std::max(static_cast<long long>(last), std::min(mapping.digits * 2, max_digits));
+            client.waiting = true;
+            start_computation(target);
+        }
+    }
+}
+
+void DigitServer::drop_client(size_t index)
+{
+    ::close(clients[index].fd);
+    clients.erase(clients.begin() + index);
+}
+
+int DigitServer::run()
+{
+    // Serve what is already on disk when it is enough, otherwise compute it first
+    if (!mapping.open(config.digits_path) || mapping.digits < config.initial_digits)
+    {
+        std::cerr << "[Server] Computing " << config.initial_digits << " decimal places before serving\n";
+        if (!compute_and_publish(config.initial_digits) || !mapping.open(config.digits_path))
+        {
+            std::cerr << "[Error] Initial computation failed: " << pi_status_string(worker_status) << "\n";
+            return 1;
+        }
+    }
+
+    if (pipe2(wake_pipe, O_CLOEXEC) != 0 || !open_socket())
+    {
+        return 1;
+    }
+
+    std::cerr << "[Server] Serving " << mapping.digits << " decimal places of " << config.digits_path
+              << " on " << config.socket_path << " (up to " << max_digits << " on request)\n";
+
+    std::vector<pollfd> fds;
+    while (!server_stop.load())
+    {
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+        for (const auto& client : clients)
+        {
+            // Parked clients and those with a reply still going out are not read, so their
+            // requests stay in order
+            short events = client.replying ? POLLOUT : client.waiting ? 0 : POLLIN;
+            fds.push_back({client.fd, events, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            std::perror("[Error] poll");
+            break;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            char done;
+            while (read(wake_pipe[0], &done, 1) < 0 && errno == EINTR) {}
+            finish_computation();
+        }
+
+        // Walk backwards so dropping a client does not shift the ones still to visit
+        for (size_t index = clients.size(); index-- > 0;)
+        {
+            ServerClient& client = clients[index];
+            short events = fds[index + 2].revents;
+
+            if (events & POLLOUT)
+            {
+                if (!send_reply(client)) client.closing = true;
+            }
+            else if (events & POLLIN)
+            {
+                ssize_t count = recv(client.fd, reinterpret_cast<char*>(&client.request) + client.received,
+                                     sizeof(DigitRequest) - client.received, 0);
+                if (count > 0)
+                {
+                    client.received += count;
+                    if (client.received == sizeof(DigitRequest)) handle_request(client);
+                }
+                else if (count == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK))
+                {
+                    client.closing = true;
+                }
+            }
+            else if (events & (POLLHUP | POLLERR))
+            {
+                client.closing = true;
+            }
+
+            if (client.closing) drop_client(index);
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            // Non-blocking, so a client that stops reading only holds up its own reply
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0)
+            {
+                clients.push_back(ServerClient{fd});
+            }
+        }
+    }
+
+    std::cerr << "[Server] Shutting down\n";
+    return 0;
+}
+
+int run_digit_server(const DigitServerConfig& config)
+{
+    std::signal(SIGINT, server_signal_handler);
+    std::signal(SIGTERM, server_signal_handler);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    DigitServer server(config);
+    return server.run();
+}
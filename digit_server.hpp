@@ -0,0 +1,69 @@
+#pragma once
+#ifndef DIGIT_SERVER_HPP
+#define DIGIT_SERVER_HPP
+
+#include <cstdint>
+#include <string>
+#include "libpi.hpp"
+
+// Digit serving daemon (--serve <socket>).
+//
+// The largest result computed so far is kept in a "3.14159..." text file (computed_pi.txt by
+// default) that is memory-mapped read only. Clients connect to a Unix domain socket and ask
+// for ranges of decimal places with fixed size binary requests; replies are sent straight from
+// the mapping with writev, so no digits are copied in user space, and go out as each client's
+// non-blocking socket takes them. A request past the end of what is held starts a larger
+// computation in the background, and the request is answered as soon as it finishes; requests
+// inside the held range keep being served meanwhile.
+//
+// All fields are in host byte order (the socket is local).
+
+constexpr uint32_t DIGIT_PROTOCOL_MAGIC = 0x47444950;      // "PIDG" on little endian hosts
+constexpr uint64_t DIGIT_MAX_RANGE = 1ULL << 30;            // Largest range one request may ask for
+
+enum DigitOp : uint32_t
+{
+    DIGIT_OP_RANGE = 1,         // Decimal places first .. first + count - 1 (first = 1 is the "1" after "3.")
+    DIGIT_OP_STATUS = 2         // Reply first = digits held, count = digits being computed (0 if idle)
+};
+
+enum DigitReplyStatus : uint32_t
+{
+    DIGIT_OK = 0,
+    DIGIT_BAD_REQUEST = 1,
+    DIGIT_TOO_LARGE = 2,        // Beyond --serve-max
+    DIGIT_FAILED = 3            // The computation needed for the request failed
+};
+
+struct DigitRequest
+{
+    uint32_t magic;
+    uint32_t op;
+    uint64_t first;
+    uint64_t count;
+};
+
+// Followed by count ASCII digits when status is DIGIT_OK and op is DIGIT_OP_RANGE
+struct DigitReply
+{
+    uint32_t magic;
+    uint32_t status;
+    uint64_t first;
+    uint64_t count;
+};
+
+static_assert(sizeof(DigitRequest) == 24 && sizeof(DigitReply) == 24, "protocol structs must not be padded");
+
+struct DigitServerConfig
+{
+    std::string socket_path;
+    std::string digits_path = "computed_pi.txt";
+    long long initial_digits = 0;           // Computed at startup unless the digits file already holds them
+    long long max_digits = 0;               // Largest computation a request may trigger, 0 = 100 x initial
+    PiOptions compute_options;              // Method, threads ... for every computation (decimal_places is set per run)
+};
+
+// Run until SIGINT or SIGTERM. Returns the process exit code.
+int run_digit_server(const DigitServerConfig& config);
+
+#endif
@@ -0,0 +1,79 @@
+#include "gauss_legendre.hpp"
+#include "instrumentation.hpp"
+
+#include <cmath>
+#include <optional>
+
+// Function to calculate pi using the Gauss_Legendre algorithm.
+PiStatus calculate_gauss_legendre_algorithm(PiContext& context, mpfr_t pi_approx)
+{
+    const PiOptions& options = context.options();
+    const mpfr_prec_t precision = context.precision();
+    const long long iterations = static_cast<long long>(log2(options.decimal_places)) + 2;
+    context.set_progress_total(iterations);
+
+    mpfr_t a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2;
+    mpfr_inits2(precision, a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, (mpfr_ptr) 0);
+
+    // Initialize variables
+    mpfr_set_d(a, 1.0, MPFR_RNDN);
+    mpfr_sqrt_ui(b, 2, MPFR_RNDN);
+    mpfr_ui_div(b, 1, b, MPFR_RNDN);
+    mpfr_set_d(t, 0.25, MPFR_RNDN);
+    mpfr_set_d(p, 1.0, MPFR_RNDN);
+
+    std::optional<TraceSpan> phase_span;
+    phase_span.emplace("agm iterations");
+
+    for (long long i = 0; i < iterations; i++)
+    {
+        if (context.cancelled())
+        {
+            mpfr_clears(a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, (mpfr_ptr) 0);  // Clean up
+            return PiStatus::Cancelled;
+        }
+
+        // a_next = (a + b) / 2.0
+        mpfr_add(a_next, a, b, MPFR_RNDN);
+        mpfr_div_ui(a_next, a_next, 2, MPFR_RNDN);
+
+        // b_next = sqrt(a * b)
+        mpfr_mul(b_next, a, b, MPFR_RNDN);
+        mpfr_sqrt(b_next, b_next, MPFR_RNDN);
+
+        // t_next = t - p * (a - a_next)^2
+        mpfr_sub(temp1, a, a_next, MPFR_RNDN);
+        mpfr_mul(temp1, temp1, temp1, MPFR_RNDN);
+        mpfr_mul(temp1, p, temp1, MPFR_RNDN);
+        mpfr_sub(t_next, t, temp1, MPFR_RNDN);
+
+        // p_next = 2 * p
+        mpfr_mul_ui(p_next, p, 2, MPFR_RNDN);
+
+        // Update
+        mpfr_set(a, a_next, MPFR_RNDN);
+        mpfr_set(b, b_next, MPFR_RNDN);
+        mpfr_set(t, t_next, MPFR_RNDN);
+        mpfr_set(p, p_next, MPFR_RNDN);
+
+        context.set_progress(i + 1);  // For monitoring
+    }
+
+    // Compute pi_approx = (a + b)^2 / (4 * t)
+    phase_span.reset();
+    phase_span.emplace("division");
+    mpfr_add(temp1, a, b, MPFR_RNDN);
+    mpfr_mul(temp1, temp1, temp1, MPFR_RNDN);
+    mpfr_mul_ui(temp2, t, 4, MPFR_RNDN);
+    mpfr_div(pi_approx, temp1, temp2, MPFR_RNDN);
+    phase_span.reset();
+
+    if (options.debug_level >= 2)
+    {
+        mpfr_printf("Final computed pi_approx=%.*Rf\n", static_cast<int>(options.decimal_places), pi_approx);
+    }
+
+    // Free temp variables
+    mpfr_clears(a, b, t, p, a_next, b_next, t_next, p_next, temp1, temp2, (mpfr_ptr) 0);
+    return PiStatus::Ok;
+}
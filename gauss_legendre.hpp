@@ -0,0 +1,11 @@
+#pragma once
+#ifndef GAUSS_LEGENDRE_HPP
+#define GAUSS_LEGENDRE_HPP
+
+#include <mpfr.h>
+#include "libpi.hpp"
+
+// Gauss-Legendre (AGM) iteration, single threaded. Doubles the correct digits per iteration.
+PiStatus calculate_gauss_legendre_algorithm(PiContext& context, mpfr_t pi_approx);
+
+#endif
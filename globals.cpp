@@ -0,0 +1,6 @@
+#include "globals.hpp"
+
+// Definitions for the variables declared in globals.hpp.
+// Kept out of calculate_pi.cpp so other binaries (e.g. the benchmark) can link the engines.
+std::mutex console_mutex;                           // Used to limit console output to a single thread at a time.
+int debug_level = 0;                                // Debug level passed in from command line
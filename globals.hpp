@@ -1,13 +1,27 @@
 #pragma once
 
-#include <atomic>
+#include <algorithm>
 #include <mutex>
+#include <type_traits>
+
+// Process wide diagnostics shared by the monitoring, tracing and placement code.
+// Computation state (precision, digits, threads, cancellation, progress) lives in
+// PiContext (libpi.hpp), not here.
 
-extern std::atomic<bool> stop_requested;
-extern int thread_count;
 extern int debug_level;
-extern bool use_multithreading;
-extern long long decimal_places;extern std::atomic<bool> stop_requested;
 extern std::mutex console_mutex;
-extern int chunk_size;
-extern mpfr_prec_t working_prec;
\ No newline at end of file
+
+// Run f(std::integral_constant<int, L>()) with L the debug level clamped to 0..3, so engines
+// can instantiate their inner loops per level and test it with if constexpr: a run at level 0
+// then executes no diagnostic branches or timing calls at all. Dispatch once, outside the loops.
+template <typename F>
+auto with_debug_level(int level, F&& f)
+{
+    switch (std::clamp(level, 0, 3))
+    {
+        case 0:  return f(std::integral_constant<int, 0>());
+        case 1:  return f(std::integral_constant<int, 1>());
+        case 2:  return f(std::integral_constant<int, 2>());
+        default: return f(std::integral_constant<int, 3>());
+    }
+}
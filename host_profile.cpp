@@ -0,0 +1,406 @@
+#include "host_profile.hpp"
+#include "container_limits.hpp"
+#include "libpi.hpp"
+#include "ntt_multiply.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr double TIE = 1.03;                // Within 3% of the best is a tie, won by the earlier candidate
+constexpr double DROP_METHOD = 4.0;         // A method this much slower than the best is not timed at larger sizes ...
+constexpr double DROP_SECONDS = 0.1;        // ... once its own run is this long, past any startup cost
+constexpr double SAMPLE_SECONDS = 0.02;     // Small runs are repeated until a sample lasts this long
+constexpr long long CHUNK_DIGITS = 20000;   // Chudnovsky runs are quadratic, so chunks are timed small
+
+std::string host_name()
+{
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0 || name[0] == '\0') return "localhost";
+    return name;
+}
+
+std::string cpu_model_name()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 10, "model name") != 0) continue;
+        size_t colon = line.find(':');
+        size_t start = (colon == std::string::npos) ? colon : line.find_first_not_of(" \t", colon + 1);
+        return start == std::string::npos ? "" : line.substr(start);
+    }
+    return "";
+}
+
+bool known_method(const std::string& name)
+{
+    return name == "gauss_legendre" || name == "chudnovsky" || name == "binary_splitting";
+}
+
+PiMethod method_from_name(const std::string& name)
+{
+    if (name == "chudnovsky") return PiMethod::Chudnovsky;
+    if (name == "binary_splitting") return PiMethod::BinarySplitting;
+    return PiMethod::GaussLegendre;
+}
+
+// Seconds per computation, the best of up to three samples (fewer once a second has been
+// spent). A sample repeats the run until it lasts SAMPLE_SECONDS, so sub-millisecond sizes
+// are averaged over many runs instead of being decided by timer resolution.
+double time_compute(const PiOptions& options)
+{
+    std::vector<char> buffer(PiContext::required_buffer_size(options.decimal_places));
+    double best = std::numeric_limits<double>::infinity();
+    double spent = 0.0;
+    for (int sample = 0; sample < 3 && spent < 1.0; ++sample)
+    {
+        auto start = std::chrono::steady_clock::now();
+        double seconds = 0.0;
+        int runs = 0;
+        do
+        {
+            PiContext context(options);
+            if (context.compute(buffer.data(), buffer.size()) != PiStatus::Ok)
+                return std::numeric_limits<double>::infinity();
+            ++runs;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < SAMPLE_SECONDS);
+        best = std::min(best, seconds / runs);
+        spent += seconds;
+    }
+    return best;
+}
+
+double time_multiply(void (*multiply)(mpz_t, const mpz_t, const mpz_t), const mpz_t a, const mpz_t b)
+{
+    mpz_t product;
+    mpz_init(product);
+    double best = std::numeric_limits<double>::infinity();
+    for (int run = 0; run < 2; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        multiply(product, a, b);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    mpz_clear(product);
+    return best;
+}
+
+// First candidate within TIE of the fastest, so the cheaper or default setting wins near ties
+size_t fastest(const std::vector<double>& seconds)
+{
+    double best = *std::min_element(seconds.begin(), seconds.end());
+    for (size_t i = 0; i < seconds.size(); ++i)
+    {
+        if (seconds[i] <= best * TIE) return i;
+    }
+    return 0;
+}
+
+void report(const std::string& what, double seconds)
+{
+    std::ostringstream line;
+    line << "[Tune] " << std::left << std::setw(40) << what << std::right;
+    if (std::isinf(seconds)) line << "failed\n";
+    else line << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms\n";
+    std::cout << line.str();
+}
+
+// Smallest operand size from which the NTT beats mpz_mul at every larger size tried, 0 if it never does
+long tune_ntt_threshold(int threads)
+{
+    ntt_configure(0, threads, "auto");
+    gmp_randstate_t random;
+    gmp_randinit_default(random);
+    gmp_randseed_ui(random, 12345);
+    mpz_t a, b;
+    mpz_init(a);
+    mpz_init(b);
+
+    long threshold = 0;
+    for (long limbs = 1L << 14; limbs <= 1L << 20; limbs <<= 1)
+    {
+        mpz_urandomb(a, random, limbs * GMP_NUMB_BITS);
+        mpz_urandomb(b, random, limbs * GMP_NUMB_BITS);
+        double gmp = time_multiply(static_cast<void (*)(mpz_t, const mpz_t, const mpz_t)>(mpz_mul), a, b);
+        double ntt = time_multiply(ntt_multiply, a, b);
+        report("mpz_mul " + std::to_string(limbs) + " limbs", gmp);
+        report("NTT (" + std::string(ntt_kernel_name()) + ") " + std::to_string(limbs) + " limbs", ntt);
+        if (ntt < gmp)
+        {
+            if (threshold == 0) threshold = limbs;
+        }
+        else
+        {
+            threshold = 0;
+        }
+    }
+
+    mpz_clear(a);
+    mpz_clear(b);
+    gmp_randclear(random);
+    return threshold;
+}
+
+} // namespace
+
+std::string default_profile_path()
+{
+    std::string file = host_name() + ".profile";
+    if (const char* config = std::getenv("XDG_CONFIG_HOME"); config && *config)
+        return std::string(config) + "/calculate_pi/" + file;
+    if (const char* home = std::getenv("HOME"); home && *home)
+        return std::string(home) + "/.config/calculate_pi/" + file;
+    return "calculate_pi." + file;
+}
+
+bool load_host_profile(const std::string& path, HostProfile& profile)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    HostProfile loaded;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) continue;
+
+        std::string value;
+        std::getline(fields >> std::ws, value);
+        while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.pop_back();
+
+        bool ok = true;
+        try
+        {
+            if (key == "host") loaded.host = value;
+            else if (key == "cpu_model") loaded.cpu_model = value;
+            else if (key == "effective_cpus") loaded.effective_cpus = std::stoi(value);
+            else if (key == "threads") loaded.threads = std::stoi(value);
+            else if (key == "chunk_size") loaded.chunk_size = std::stoi(value);
+            else if (key == "leaf_size") loaded.leaf_size = std::stoi(value);
+            else if (key == "ntt_threshold") loaded.ntt_threshold = std::stol(value);
+            else if (key == "method")
+            {
+                MethodCrossover crossover;
+                std::istringstream range(value);
+                std::string extra;
+                ok = (range >> crossover.from_digits >> crossover.method) && !(range >> extra) &&
+                     known_method(crossover.method) && crossover.from_digits >= 0 &&
+                     (loaded.methods.empty() || crossover.from_digits > loaded.methods.back().from_digits);
+                if (ok) loaded.methods.push_back(crossover);
+            }
+            else ok = false;
+        }
+        catch (const std::exception&)
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Error: " << path << ":" << line_number << ": unexpected profile line: " << line << "\n";
+            return false;
+        }
+    }
+
+    profile = loaded;
+    return true;
+}
+
+bool save_host_profile(const std::string& path, const HostProfile& profile)
+{
+    std::error_code error;
+    std::filesystem::path target(path);
+    if (target.has_parent_path() && !std::filesystem::create_directories(target.parent_path(), error) && error)
+    {
+        std::cerr << "Error: Could not create " << target.parent_path().string() << ": " << error.message() << "\n";
+        return false;
+    }
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << "# calculate_pi host profile, written by --tune\n"
+             << "host " << profile.host << "\n"
+             << "cpu_model " << profile.cpu_model << "\n"
+             << "effective_cpus " << profile.effective_cpus << "\n"
+             << "threads " << profile.threads << "\n"
+             << "chunk_size " << profile.chunk_size << "\n"
+             << "leaf_size " << profile.leaf_size << "\n"
+             << "ntt_threshold " << profile.ntt_threshold << "\n";
+        for (const auto& crossover : profile.methods)
+        {
+            file << "method " << crossover.from_digits << " " << crossover.method << "\n";
+        }
+        if (!file.flush())
+        {
+            std::cerr << "Error: Could not write host profile: " << temporary << "\n";
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Error: Could not rename " << temporary << " to " << path << "\n";
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool host_profile_matches(const HostProfile& profile, std::string& reason)
+{
+    int cpus = container_limits().effective_cpus;
+    if (profile.effective_cpus != cpus)
+    {
+        reason = "tuned for " + std::to_string(profile.effective_cpus) + " CPUs, " + std::to_string(cpus) + " usable now";
+        return false;
+    }
+    std::string model = cpu_model_name();
+    if (profile.cpu_model != model)
+    {
+        reason = "tuned on " + (profile.cpu_model.empty() ? std::string("an unknown CPU") : profile.cpu_model);
+        return false;
+    }
+    return true;
+}
+
+std::string host_profile_method(const HostProfile& profile, long long digits)
+{
+    std::string method;
+    for (const auto& crossover : profile.methods)
+    {
+        if (digits >= crossover.from_digits) method = crossover.method;
+    }
+    return method;
+}
+
+HostProfile tune_host_profile(long long target_digits, int debug_level)
+{
+    HostProfile profile;
+    profile.host = host_name();
+    profile.cpu_model = cpu_model_name();
+    profile.effective_cpus = container_limits().effective_cpus;
+
+    // Same ceiling as the default: one CPU stays free for the main and monitoring threads
+    int max_threads = std::max(1, profile.effective_cpus - 1);
+    ntt_configure(0, max_threads, "auto");
+
+    PiOptions options;
+    options.method = PiMethod::BinarySplitting;
+    options.decimal_places = target_digits;
+    options.debug_level = debug_level >= 3 ? 1 : 0;
+
+    // Threads: powers of two up to the ceiling, binary splitting at the target size
+    std::vector<int> thread_candidates;
+    for (int threads = 1; threads < max_threads; threads *= 2) thread_candidates.push_back(threads);
+    thread_candidates.push_back(max_threads);
+    std::vector<double> seconds;
+    for (int threads : thread_candidates)
+    {
+        options.threads = threads;
+        seconds.push_back(time_compute(options));
+        report("binary_splitting, " + std::to_string(threads) + " threads", seconds.back());
+    }
+    profile.threads = thread_candidates[fastest(seconds)];
+    options.threads = profile.threads;
+
+    // Leaf size, the current default first so it keeps near ties
+    const std::vector<int> leaf_candidates = {32, 16, 64, 8, 128};
+    seconds.clear();
+    for (int leaf : leaf_candidates)
+    {
+        options.leaf_size = leaf;
+        seconds.push_back(time_compute(options));
+        report("binary_splitting, leaf size " + std::to_string(leaf), seconds.back());
+    }
+    profile.leaf_size = leaf_candidates[fastest(seconds)];
+    options.leaf_size = profile.leaf_size;
+
+    // Dynamic Chudnovsky chunks only matter with several workers
+    profile.chunk_size = 100;
+    if (profile.threads > 1)
+    {
+        PiOptions chunk_options = options;
+        chunk_options.method = PiMethod::Chudnovsky;
+        chunk_options.dynamic = true;
+        chunk_options.decimal_places = std::min(target_digits, CHUNK_DIGITS);
+        const std::vector<int> chunk_candidates = {100, 50, 200, 25, 400};
+        seconds.clear();
+        for (int chunk : chunk_candidates)
+        {
+            chunk_options.chunk_size = chunk;
+            seconds.push_back(time_compute(chunk_options));
+            report("chudnovsky --dynamic, chunk " + std::to_string(chunk), seconds.back());
+        }
+        profile.chunk_size = chunk_candidates[fastest(seconds)];
+    }
+    options.chunk_size = profile.chunk_size;
+
+    // NTT multiply needs several cores to win, so one thread leaves it off
+    profile.ntt_threshold = (profile.threads > 1) ? tune_ntt_threshold(profile.threads) : 0;
+    ntt_configure(profile.ntt_threshold, profile.threads, "auto");
+
+    // Method crossovers: every method at 1000, 10000, ... and the target size. A method is
+    // dropped only once a run of its own takes DROP_SECONDS and is DROP_METHOD times the best,
+    // so thread startup at small sizes cannot rule it out. A change of winner goes in at the
+    // geometric mean of the sizes.
+    const std::vector<std::string> methods = {"binary_splitting", "chudnovsky", "gauss_legendre"};
+    std::vector<bool> dropped(methods.size(), false);
+    std::vector<long long> sizes;
+    for (long long size = 1000; size < target_digits; size *= 10) sizes.push_back(size);
+    sizes.push_back(target_digits);
+
+    long long previous_size = 0;
+    for (long long size : sizes)
+    {
+        options.decimal_places = size;
+        seconds.assign(methods.size(), std::numeric_limits<double>::infinity());
+        for (size_t m = 0; m < methods.size(); ++m)
+        {
+            if (dropped[m]) continue;
+            options.method = method_from_name(methods[m]);
+            seconds[m] = time_compute(options);
+            report(methods[m] + ", " + std::to_string(size) + " digits", seconds[m]);
+        }
+        size_t winner = fastest(seconds);
+        for (size_t m = 0; m < methods.size(); ++m)
+        {
+            if (seconds[m] >= DROP_SECONDS && seconds[m] > seconds[winner] * DROP_METHOD) dropped[m] = true;
+        }
+        if (profile.methods.empty() || profile.methods.back().method != methods[winner])
+        {
+            long long from = profile.methods.empty() ? 0 : std::llround(std::sqrt(double(previous_size) * size));
+            profile.methods.push_back({from, methods[winner]});
+        }
+        previous_size = size;
+    }
+    return profile;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef HOST_PROFILE_HPP
+#define HOST_PROFILE_HPP
+
+#include <string>
+#include <vector>
+
+// Per-host performance profile (--tune).
+//
+// `calculate_pi --tune` times short runs on this machine and writes the fastest settings it
+// finds: worker threads, binary splitting leaf size, dynamic Chudnovsky chunk size, the NTT
+// multiply threshold and the sizes at which one method overtakes another. Later runs load the
+// profile for their host and use it wherever the command line leaves a setting at its default.
+//
+// The file is plain text, one "key value" per line, # comments ignored:
+//   host node17
+//   cpu_model AMD EPYC 7763 64-Core Processor
+//   effective_cpus 16
+//   threads 15
+//   chunk_size 100
+//   leaf_size 32
+//   ntt_threshold 131072
+//   method 0 binary_splitting        (fastest method from this many decimal places up)
+// A profile tuned on another CPU model or CPU count is ignored with a warning.
+
+struct MethodCrossover
+{
+    long long from_digits = 0;          // This method is the fastest from here to the next entry
+    std::string method;                 // gauss_legendre, chudnovsky or binary_splitting
+};
+
+struct HostProfile
+{
+    std::string host;                   // gethostname() when tuned
+    std::string cpu_model;              // "model name" in /proc/cpuinfo, empty when unknown
+    int effective_cpus = 0;             // container_limits().effective_cpus when tuned
+    int threads = 0;                    // Worker threads for chudnovsky and binary_splitting
+    int chunk_size = 0;                 // Terms per dynamic Chudnovsky chunk
+    int leaf_size = 0;                  // Binary splitting terms per leaf
+    long ntt_threshold = -1;            // NTT multiply from this many limbs, 0 = off
+    std::vector<MethodCrossover> methods;   // Ascending from_digits, the first at 0
+};
+
+// $XDG_CONFIG_HOME/calculate_pi/<host>.profile, or under ~/.config, or the current directory
+std::string default_profile_path();
+
+// False when the file is missing or malformed (malformed lines are reported)
+bool load_host_profile(const std::string& path, HostProfile& profile);
+
+// Write through a .tmp file and rename, creating the directory
+bool save_host_profile(const std::string& path, const HostProfile& profile);
+
+// Whether profile was tuned on hardware like this host's; reason says why not
+bool host_profile_matches(const HostProfile& profile, std::string& reason);
+
+// Fastest tuned method for digits decimal places, empty when the profile has none
+std::string host_profile_method(const HostProfile& profile, long long digits);
+
+// Run the calibration with computations of up to target_digits decimal places
+HostProfile tune_host_profile(long long target_digits, int debug_level);
+
+#endif
@@ -0,0 +1,506 @@
+#pragma once
+#ifndef HYPERGEOMETRIC_HPP
+#define HYPERGEOMETRIC_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_splitting.hpp"
+#include "instrumentation.hpp"
+#include "ntt_multiply.hpp"
+#include "prime_factors.hpp"
+#include "self_check.hpp"
+#include "series_constants.hpp"
+#include "thread_placement.hpp"
+
+// Binary splitting engine over a series description from series_constants.hpp.
+// See binary_splitting.hpp for the P, Q, T state and how ranges merge.
+
+template <typename Series>
+unsigned long series_terms_for_digits(long long decimal_places)
+{
+    if constexpr (Series::digits_per_term > 0)
+    {
+        return static_cast<unsigned long>(decimal_places / Series::digits_per_term) + 2;
+    }
+    else
+    {
+        // 1/k! series: the first N with log10(N!) past the digits wanted
+        unsigned long low = 1, high = 2;
+        auto enough = [&](unsigned long n) { return std::lgamma(n + 1.0) / std::log(10.0) > decimal_places + 2; };
+        while (!enough(high)) high *= 2;
+        while (low < high)
+        {
+            unsigned long middle = low + (high - low) / 2;
+            if (enough(middle)) high = middle; else low = middle + 1;
+        }
+        return high + 1;
+    }
+}
+
+// value := scale * prod (slope * k + offset)
+template <size_t N>
+inline void series_linear_product(mpz_t value, unsigned long scale, const std::array<LinearFactor, N>& factors, unsigned long k)
+{
+    mpz_set_ui(value, scale);
+    for (const LinearFactor& factor : factors)
+    {
+        mpz_mul_ui(value, value, factor.slope * k + factor.offset);
+    }
+}
+
+// The single term k: P = p(k), Q = q(k), T = (+/-) a(k) p(k), with P = Q = 1 for k = 0
+template <typename Series>
+inline void series_leaf(unsigned long k, mpz_t P, mpz_t Q, mpz_t T)
+{
+    if (k == 0)
+    {
+        mpz_set_ui(P, 1);
+        mpz_set_ui(Q, 1);
+    }
+    else
+    {
+        series_linear_product(P, Series::p_scale, Series::p_factors, k);
+        series_linear_product(Q, Series::q_scale, Series::q_factors, k);
+    }
+
+    // a(k) by Horner, highest coefficient first
+    constexpr size_t degree = Series::a_coefficients.size() - 1;
+    if constexpr (degree == 0)
+    {
+        mpz_mul_ui(T, P, Series::a_coefficients[0]);
+    }
+    else
+    {
+        mpz_set_ui(T, Series::a_coefficients[degree]);
+        for (size_t i = degree; i-- > 0;)
+        {
+            mpz_mul_ui(T, T, k);
+            mpz_add_ui(T, T, Series::a_coefficients[i]);
+        }
+        mpz_mul(T, T, P);
+    }
+
+    if (Series::alternating && k % 2 == 1) mpz_neg(T, T);
+}
+
+// The recursion stops at leaves of options().leaf_size terms. Their factors are built
+// SERIES_LEAF_BATCH terms at a time in native 128-bit integers, and runs of consecutive terms
+// are combined in __int128 until the next one would overflow. Only then is the run folded
+// into the mpz P, Q, T, as a two-limb operand: most terms never touch GMP on their own.
+constexpr unsigned long SERIES_LEAF_BATCH = 16;
+
+static_assert(GMP_NUMB_BITS == 64, "the leaf batch assumes 64-bit limbs");
+
+// Read-only mpz over x, no allocation (limbs must outlive the view)
+inline mpz_srcptr mpz_view_u128(mpz_t view, mp_limb_t limbs[2], unsigned __int128 x)
+{
+    limbs[0] = static_cast<mp_limb_t>(x);
+    limbs[1] = static_cast<mp_limb_t>(x >> 64);
+    return mpz_roinit_n(view, limbs, limbs[1] != 0 ? 2 : (limbs[0] != 0 ? 1 : 0));
+}
+
+// Largest k whose p(k), q(k) and a(k) p(k) fit in 127 bits. The factors and a(k) grow with
+// k, so a batch fits when its last term does.
+template <typename Series>
+unsigned long series_leaf_batch_limit()
+{
+    static const unsigned long limit = [] {
+        auto bits = [](unsigned long k) {
+            double kk = static_cast<double>(k);
+            double p_bits = std::log2(static_cast<double>(Series::p_scale));
+            double q_bits = std::log2(static_cast<double>(Series::q_scale));
+            for (const LinearFactor& factor : Series::p_factors) p_bits += std::log2(factor.slope * kk + std::abs(factor.offset) + 1);
+            for (const LinearFactor& factor : Series::q_factors) q_bits += std::log2(factor.slope * kk + std::abs(factor.offset) + 1);
+            double a = 0;
+            for (size_t i = Series::a_coefficients.size(); i-- > 0;) a = a * kk + Series::a_coefficients[i];
+            return std::max(p_bits + std::log2(a + 1), q_bits);
+        };
+        unsigned long k = 1;
+        while (k < (1UL << 40) && bits(2 * k) < 126) k *= 2;
+        return k;
+    }();
+    return limit;
+}
+
+// p(k), q(k) and a(k) p(k) for k in [k0, k0 + count), each step one loop over the batch
+template <typename Series>
+void series_leaf_factors(unsigned long k0, size_t count, unsigned __int128* p, unsigned __int128* q, unsigned __int128* t)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        p[i] = Series::p_scale;
+        q[i] = Series::q_scale;
+    }
+    for (const LinearFactor& factor : Series::p_factors)
+    {
+        for (size_t i = 0; i < count; ++i) p[i] *= factor.slope * (k0 + i) + factor.offset;
+    }
+    for (const LinearFactor& factor : Series::q_factors)
+    {
+        for (size_t i = 0; i < count; ++i) q[i] *= factor.slope * (k0 + i) + factor.offset;
+    }
+    if (k0 == 0)
+    {
+        p[0] = 1;
+        q[0] = 1;
+    }
+
+    // a(k) by Horner, highest coefficient first
+    constexpr size_t degree = Series::a_coefficients.size() - 1;
+    for (size_t i = 0; i < count; ++i) t[i] = Series::a_coefficients[degree];
+    for (size_t j = degree; j-- > 0;)
+    {
+        for (size_t i = 0; i < count; ++i) t[i] = t[i] * (k0 + i) + Series::a_coefficients[j];
+    }
+    for (size_t i = 0; i < count; ++i) t[i] *= p[i];
+}
+
+// P, Q, T of a run of consecutive terms in native integers (P, Q > 0, T signed)
+struct NativeRun
+{
+    __int128 P = 1, Q = 1, T = 0;                   // The empty run
+
+    // Append the term with factors p, q and t = (+/-) a p. False, with the run unchanged,
+    // when the result would not fit.
+    bool append(__int128 p, __int128 q, __int128 t)
+    {
+        __int128 Tq, Pt, next_T, next_P, next_Q;
+        if (__builtin_mul_overflow(T, q, &Tq) || __builtin_mul_overflow(P, t, &Pt) ||
+            __builtin_add_overflow(Tq, Pt, &next_T) || __builtin_mul_overflow(P, p, &next_P) ||
+            __builtin_mul_overflow(Q, q, &next_Q))
+        {
+            return false;
+        }
+        P = next_P;
+        Q = next_Q;
+        T = next_T;
+        return true;
+    }
+};
+
+// P, Q, T := the terms so far followed by run (started is false before the first run)
+inline void series_fold_run(const NativeRun& run, bool started, mpz_t P, mpz_t Q, mpz_t T)
+{
+    mp_limb_t p_limbs[2], q_limbs[2], t_limbs[2];
+    mpz_t p_view, q_view, t_view;
+    mpz_view_u128(p_view, p_limbs, static_cast<unsigned __int128>(run.P));
+    mpz_view_u128(q_view, q_limbs, static_cast<unsigned __int128>(run.Q));
+    mpz_view_u128(t_view, t_limbs, static_cast<unsigned __int128>(run.T < 0 ? -run.T : run.T));
+
+    if (!started)
+    {
+        mpz_set(P, p_view);
+        mpz_set(Q, q_view);
+        mpz_set(T, t_view);
+        if (run.T < 0) mpz_neg(T, T);
+        return;
+    }
+
+    // T = T Q_run + P T_run, P = P P_run, Q = Q Q_run
+    mpz_mul(T, T, q_view);
+    if (run.T < 0)
+        mpz_submul(T, P, t_view);
+    else
+        mpz_addmul(T, P, t_view);
+    mpz_mul(P, P, p_view);
+    mpz_mul(Q, Q, q_view);
+}
+
+// Terms [a, b). Those up to series_leaf_batch_limit are combined natively; any past it, whose
+// factors would overflow 128 bits, are appended one mpz leaf at a time.
+template <typename Series>
+void series_leaf_batch(unsigned long a, unsigned long b, mpz_t P, mpz_t Q, mpz_t T)
+{
+    unsigned __int128 p[SERIES_LEAF_BATCH] = {}, q[SERIES_LEAF_BATCH] = {}, t[SERIES_LEAF_BATCH] = {};
+    NativeRun run;
+    bool started = false;
+    const unsigned long native_end = std::min(b, std::max(a, series_leaf_batch_limit<Series>() + 1));
+
+    for (unsigned long k0 = a; k0 < native_end; k0 += SERIES_LEAF_BATCH)
+    {
+        size_t count = std::min(SERIES_LEAF_BATCH, native_end - k0);
+        series_leaf_factors<Series>(k0, count, p, q, t);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            __int128 term = static_cast<__int128>(t[i]);
+            if (Series::alternating && (k0 + i) % 2 == 1) term = -term;
+
+            if (!run.append(static_cast<__int128>(p[i]), static_cast<__int128>(q[i]), term))
+            {
+                series_fold_run(run, started, P, Q, T);
+                started = true;
+                run = NativeRun();
+                run.append(static_cast<__int128>(p[i]), static_cast<__int128>(q[i]), term);     // Fits alone
+            }
+        }
+    }
+    series_fold_run(run, started, P, Q, T);     // The empty run leaves P = Q = 1, T = 0
+
+    if (native_end < b)
+    {
+        mpz_t P2, Q2, T2;
+        mpz_inits(P2, Q2, T2, nullptr);
+        for (unsigned long k = native_end; k < b; ++k)
+        {
+            series_leaf<Series>(k, P2, Q2, T2);
+            mpz_mul(T, T, Q2);
+            mpz_addmul(T, P, T2);
+            mpz_mul(P, P, P2);
+            mpz_mul(Q, Q, Q2);
+        }
+        mpz_clears(P2, Q2, T2, nullptr);
+    }
+}
+
+// Terms [a, b) into P, Q, T. Returns false once the context is cancelled.
+template <typename Series>
+bool series_split(PiContext& context, unsigned long a, unsigned long b, mpz_t P, mpz_t Q, mpz_t T)
+{
+    if (b - a <= static_cast<unsigned long>(context.options().leaf_size) && b - 1 <= series_leaf_batch_limit<Series>())
+    {
+        series_leaf_batch<Series>(a, b, P, Q, T);
+        context.add_progress(b - a);
+        return true;
+    }
+
+    if (b - a == 1)
+    {
+        series_leaf<Series>(a, P, Q, T);
+        context.add_progress(1);
+        return true;
+    }
+
+    if (context.cancelled()) return false;
+
+    unsigned long m = a + (b - a) / 2;
+    mpz_t P2, Q2, T2;
+    mpz_inits(P2, Q2, T2, nullptr);
+
+    bool ok = series_split<Series>(context, a, m, P, Q, T) && series_split<Series>(context, m, b, P2, Q2, T2);
+    if (ok)
+    {
+        big_multiply(T, T, Q2);
+        big_multiply(T2, T2, P);
+        big_add(T, T, T2);
+        big_multiply(P, P, P2);
+        big_multiply(Q, Q, Q2);
+    }
+
+    mpz_clears(P2, Q2, T2, nullptr);
+    return ok;
+}
+
+// Largest linear factor value for terms below end, the sieve size for --factorized
+template <typename Series>
+uint64_t series_sieve_limit(unsigned long end)
+{
+    uint64_t limit = 2;
+    for (const LinearFactor& factor : Series::p_factors) limit = std::max<uint64_t>(limit, factor.slope * end + std::abs(factor.offset));
+    for (const LinearFactor& factor : Series::q_factors) limit = std::max<uint64_t>(limit, factor.slope * end + std::abs(factor.offset));
+    return limit;
+}
+
+// Append the factorization of prod over k in [first, b) of the linear factors. Repeated
+// factors (k k k in the Chudnovsky q) are factored once with their multiplicity.
+template <size_t N>
+void series_linear_prime_factors(const PrimeSieve& sieve, const std::array<LinearFactor, N>& factors, unsigned long first,
+                                 unsigned long b, PrimeFactors& out)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        bool repeat = false;
+        uint32_t times = 0;
+        for (size_t j = 0; j < N; ++j)
+        {
+            bool same = factors[j].slope == factors[i].slope && factors[j].offset == factors[i].offset;
+            if (same && j < i) repeat = true;
+            if (same) ++times;
+        }
+        if (repeat) continue;
+
+        for (unsigned long k = first; k < b; ++k) sieve.factor(factors[i].slope * k + factors[i].offset, out, times);
+    }
+}
+
+// Factorizations of P and Q for the terms [a, b) (p = q = 1 for k = 0)
+template <typename Series>
+void series_leaf_prime_factors(const PrimeSieve& sieve, unsigned long a, unsigned long b, PrimeFactors& p_factors, PrimeFactors& q_factors)
+{
+    p_factors.clear();
+    q_factors.clear();
+    unsigned long first = std::max(a, 1UL);
+    if (first < b)
+    {
+        sieve.factor(Series::p_scale, p_factors, b - first);
+        sieve.factor(Series::q_scale, q_factors, b - first);
+    }
+    series_linear_prime_factors(sieve, Series::p_factors, first, b, p_factors);
+    series_linear_prime_factors(sieve, Series::q_factors, first, b, q_factors);
+    factors_normalize(p_factors);
+    factors_normalize(q_factors);
+}
+
+// series_split that also tracks the factorizations of P and Q. Before each merge the
+// primes P1 and Q2 share, d = gcd(P1, Q2), are divided out of both: d divides
+// T = T1 Q2 + P1 T2 too, so (P/d, Q/d, T/d) is the same series state with smaller numbers.
+template <typename Series>
+bool series_split_factorized(PiContext& context, const PrimeSieve& sieve, unsigned long a, unsigned long b,
+                             mpz_t P, mpz_t Q, mpz_t T, PrimeFactors& p_factors, PrimeFactors& q_factors)
+{
+    if (b - a <= static_cast<unsigned long>(context.options().leaf_size))
+    {
+        if (!series_split<Series>(context, a, b, P, Q, T)) return false;
+        series_leaf_prime_factors<Series>(sieve, a, b, p_factors, q_factors);
+        return true;
+    }
+
+    if (context.cancelled()) return false;
+
+    unsigned long m = a + (b - a) / 2;
+    mpz_t P2, Q2, T2;
+    mpz_inits(P2, Q2, T2, nullptr);
+    PrimeFactors p_factors2, q_factors2;
+
+    bool ok = series_split_factorized<Series>(context, sieve, a, m, P, Q, T, p_factors, q_factors) &&
+              series_split_factorized<Series>(context, sieve, m, b, P2, Q2, T2, p_factors2, q_factors2);
+    if (ok)
+    {
+        PrimeFactors common;
+        factors_common(p_factors, q_factors2, common);
+        if (!common.empty())
+        {
+            mpz_t divisor;
+            mpz_init(divisor);
+            factors_product(divisor, common);
+            mpz_divexact(P, P, divisor);
+            mpz_divexact(Q2, Q2, divisor);
+            mpz_clear(divisor);
+            factors_remove(p_factors, common);
+            factors_remove(q_factors2, common);
+        }
+
+        big_multiply(T, T, Q2);
+        big_multiply(T2, T2, P);
+        big_add(T, T, T2);
+        big_multiply(P, P, P2);
+        big_multiply(Q, Q, Q2);
+        factors_add(p_factors, p_factors2);
+        factors_add(q_factors, q_factors2);
+    }
+
+    mpz_clears(P2, Q2, T2, nullptr);
+    return ok;
+}
+
+// Terms [begin, end) into out, one contiguous slice per thread of the context's budget
+template <typename Series>
+PiStatus series_split_range(PiContext& context, unsigned long begin, unsigned long end, SeriesState& out)
+{
+    const PiOptions& options = context.options();
+    SeriesState result;
+    result.begin = begin;
+    result.end = begin;
+    uint64_t unrecovered = self_check_unrecovered();
+
+    if (end <= begin)
+    {
+        out.swap(result);
+        return PiStatus::Ok;
+    }
+
+    // Each worker splits a contiguous slice; the slices are then merged in order
+    unsigned long count = end - begin;
+    int pieces = static_cast<int>(std::min<unsigned long>(options.threads, count));
+    std::vector<SeriesState> slices(pieces);
+    std::vector<char> completed(pieces, 0);
+
+    // --factorized: smallest prime factors of every linear factor value, shared by the workers
+    std::unique_ptr<PrimeSieve> sieve;
+    if (options.factorized)
+    {
+        TraceSpan sieve_span("sieve");
+        sieve = std::make_unique<PrimeSieve>(series_sieve_limit<Series>(end));
+    }
+
+    auto run_slice = [&](int index) {
+        SeriesState& slice = slices[index];
+        slice.begin = begin + count * index / pieces;
+        slice.end = begin + count * (index + 1) / pieces;
+        if (sieve)
+        {
+            PrimeFactors p_factors, q_factors;
+            completed[index] = series_split_factorized<Series>(context, *sieve, slice.begin, slice.end, slice.P, slice.Q,
+                                                               slice.T, p_factors, q_factors);
+        }
+        else
+        {
+            completed[index] = series_split<Series>(context, slice.begin, slice.end, slice.P, slice.Q, slice.T);
+        }
+    };
+
+    {
+        TraceSpan series_span("series");
+        if (pieces == 1)
+        {
+            run_slice(0);
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            for (int i = 0; i < pieces; ++i)
+            {
+                threads.emplace_back([&, i]() {
+                    placement_apply(i);
+                    trace_set_thread_name("worker " + std::to_string(i));
+                    TraceSpan worker_span("series", "worker", begin + count * i / pieces);
+                    run_slice(i);
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+        }
+    }
+
+    if (context.cancelled() || std::find(completed.begin(), completed.end(), 0) != completed.end())
+    {
+        return PiStatus::Cancelled;
+    }
+
+    TraceSpan merge_span("merge");
+    for (auto& slice : slices)
+    {
+        merge_series(result, slice);
+    }
+    if (self_check_unrecovered() != unrecovered)
+    {
+        self_check_report_discarded("series state");
+        return PiStatus::Error;
+    }
+    out.swap(result);
+    return PiStatus::Ok;
+}
+
+// The whole constant at the context's precision
+template <typename Series>
+PiStatus series_compute(PiContext& context, mpfr_t result)
+{
+    unsigned long terms = series_terms_for_digits<Series>(context.options().decimal_places);
+    context.set_progress_total(terms);
+
+    SeriesState series;
+    PiStatus status = series_split_range<Series>(context, 0, terms, series);
+    if (status != PiStatus::Ok) return status;
+
+    TraceSpan division_span("division");
+    Series::finish(result, series.Q, series.T);
+    return PiStatus::Ok;
+}
+
+#endif
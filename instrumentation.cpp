@@ -0,0 +1,253 @@
+#include "instrumentation.hpp"
+#include "globals.hpp"
+#include "power_monitor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    long long arg;
+    long long start_us;
+    long long duration_us;
+};
+
+// One buffer per thread, owned by the registry so the events survive thread exit.
+struct ThreadTraceBuffer {
+    int tid;
+    std::string thread_name;
+    std::vector<TraceEvent> events;
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadTraceBuffer>> registry;
+static std::atomic<const char*> current_phase_name("idle");
+static std::atomic<bool> recording(false);
+static thread_local std::string thread_name_set;       // Kept until the thread's buffer exists
+
+static const std::chrono::steady_clock::time_point trace_origin = std::chrono::steady_clock::now();
+
+long long trace_now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - trace_origin).count();
+}
+
+static ThreadTraceBuffer& thread_buffer()
+{
+    thread_local ThreadTraceBuffer* buffer = nullptr;
+    if (buffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::make_unique<ThreadTraceBuffer>());
+        buffer = registry.back().get();
+        buffer->tid = static_cast<int>(registry.size()) - 1;
+        if (!thread_name_set.empty())
+            buffer->thread_name = thread_name_set;
+        else
+            buffer->thread_name = (buffer->tid == 0) ? "main" : "thread " + std::to_string(buffer->tid);
+        buffer->events.reserve(1024);
+    }
+    return *buffer;
+}
+
+void trace_recording_enable()
+{
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void trace_set_thread_name(const std::string& name)
+{
+    thread_name_set = name;
+    if (!recording.load(std::memory_order_relaxed)) return;
+
+    ThreadTraceBuffer& buffer = thread_buffer();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    buffer.thread_name = name;
+}
+
+const char* trace_current_phase()
+{
+    return current_phase_name.load(std::memory_order_relaxed);
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category, long long arg)
+    : name(name), category(category), previous_phase(nullptr), arg(arg), start_us(trace_now_us())
+{
+    if (category[0] == 'p')  // "phase"
+    {
+        // Energy used so far belongs to the phase that was running before this one
+        if (energy_monitoring_enabled()) energy_phase_boundary(trace_current_phase());
+        previous_phase = current_phase_name.exchange(name, std::memory_order_relaxed);
+    }
+    if (category[0] != 'c' && perf_counters_enabled())  // not "chunk"
+    {
+        perf_start = perf_counters_snapshot();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (recording.load(std::memory_order_relaxed))
+    {
+        long long end_us = trace_now_us();
+        thread_buffer().events.push_back({name, category, arg, start_us, end_us - start_us});
+    }
+
+    if (perf_start.valid)
+    {
+        perf_counters_accumulate(name, perf_start, perf_counters_snapshot());
+    }
+
+    if (previous_phase != nullptr)
+    {
+        if (energy_monitoring_enabled()) energy_phase_boundary(name);
+        current_phase_name.store(previous_phase, std::memory_order_relaxed);
+    }
+}
+
+long long TraceSpan::elapsed_us() const
+{
+    return trace_now_us() - start_us;
+}
+
+void print_phase_summary()
+{
+    struct Totals {
+        long long count = 0;
+        long long total_us = 0;
+        long long min_us = -1;
+        long long max_us = 0;
+    };
+
+    // Keep phases in the order they first ran
+    std::vector<std::string> phase_order;
+    std::map<std::string, Totals> phases;
+    Totals workers, chunks;
+
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& buffer : registry)
+        {
+            for (const TraceEvent& e : buffer->events)
+            {
+                Totals* t = nullptr;
+                std::string category = e.category;
+                if (category == "phase")
+                {
+                    if (phases.find(e.name) == phases.end()) phase_order.push_back(e.name);
+                    t = &phases[e.name];
+                }
+                else if (category == "worker") t = &workers;
+                else if (category == "chunk")  t = &chunks;
+                else continue;
+
+                t->count++;
+                t->total_us += e.duration_us;
+                t->min_us = (t->min_us < 0) ? e.duration_us : std::min(t->min_us, e.duration_us);
+                t->max_us = std::max(t->max_us, e.duration_us);
+            }
+        }
+    }
+
+    double wall_ms = trace_now_us() / 1000.0;
+    const int label_width = 18;
+
+    std::lock_guard<std::mutex> lock(console_mutex);
+    std::cout << "\n--- Phase Summary ---\n";
+    std::cout << std::left << std::setw(label_width) << "Phase" << std::right
+              << std::setw(8) << "Count" << std::setw(14) << "Total ms" << std::setw(10) << "% wall" << "\n";
+
+    for (const auto& name : phase_order)
+    {
+        const Totals& t = phases[name];
+        std::cout << std::left << std::setw(label_width) << name << std::right
+                  << std::setw(8) << t.count
+                  << std::setw(14) << std::fixed << std::setprecision(3) << t.total_us / 1000.0
+                  << std::setw(10) << std::setprecision(1) << (wall_ms > 0 ? 100.0 * t.total_us / 1000.0 / wall_ms : 0.0)
+                  << "\n";
+    }
+    std::cout << std::left << std::setw(label_width) << "Wall time" << std::right
+              << std::setw(8) << "" << std::setw(14) << std::setprecision(3) << wall_ms << "\n";
+
+    if (workers.count > 0)
+    {
+        std::cout << "Worker threads: " << workers.count
+                  << "  min " << std::setprecision(3) << workers.min_us / 1000.0 << " ms"
+                  << "  avg " << workers.total_us / 1000.0 / workers.count << " ms"
+                  << "  max " << workers.max_us / 1000.0 << " ms\n";
+    }
+    if (chunks.count > 0)
+    {
+        std::cout << "Chunks: " << chunks.count
+                  << "  avg " << std::setprecision(3) << chunks.total_us / 1000.0 / chunks.count << " ms"
+                  << "  max " << chunks.max_us / 1000.0 << " ms\n";
+    }
+}
+
+static void write_json_string(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+bool write_chrome_trace(const std::string& filename)
+{
+    std::ofstream out(filename);
+    if (!out)
+    {
+        std::cerr << "Error: Could not open trace file " << filename << " for writing.\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    for (const auto& buffer : registry)
+    {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+        write_json_string(out, buffer->thread_name);
+        out << "}}";
+
+        for (const TraceEvent& e : buffer->events)
+        {
+            out << ",\n{\"ph\":\"X\",\"name\":";
+            write_json_string(out, e.name);
+            out << ",\"cat\":";
+            write_json_string(out, e.category);
+            out << ",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << e.start_us << ",\"dur\":" << e.duration_us;
+            if (e.arg >= 0)
+            {
+                out << ",\"args\":{\"k\":" << e.arg << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        std::cerr << "Error: Failed while writing trace file " << filename << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <string>
+#include "perf_counters.hpp"
+
+// Lightweight span recorder used to find out where wall time goes in long runs.
+//
+// Each thread appends completed spans to its own buffer, so recording takes no locks
+// after the first span on a thread. Names and categories must be string literals
+// (or otherwise outlive the program) because only the pointer is stored.
+//
+// Categories used by the engines:
+//   "phase"  - top level steps on the main thread (series, merge, sqrt, division ...)
+//   "worker" - the whole life of one worker thread
+//   "chunk"  - a block of consecutive terms, arg holds the first k
+//
+// Spans are only stored once trace_recording_enable() has been called (for --trace and the
+// phase summary), so a long-lived process that never reports them does not accumulate them.
+// Phase tracking, perf counters and energy accounting work either way.
+//
+// When --perf-counters is enabled, "phase" and "worker" spans also attribute the
+// thread's hardware counter deltas to the span name. With energy accounting on,
+// opening and closing a "phase" span samples the RAPL counters.
+
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category = "phase", long long arg = -1);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Microseconds since the span was opened
+    long long elapsed_us() const;
+
+private:
+    const char* name;
+    const char* category;
+    const char* previous_phase;
+    long long arg;
+    long long start_us;
+    PerfSnapshot perf_start;
+};
+
+// Start storing completed spans for print_phase_summary() and write_chrome_trace()
+void trace_recording_enable();
+
+// Name the calling thread in the trace output (e.g. "main", "worker 3")
+void trace_set_thread_name(const std::string& name);
+
+// Name of the innermost "phase" span currently open, or "idle"
+const char* trace_current_phase();
+
+// Microseconds since the process started recording
+long long trace_now_us();
+
+// Print a table of time per phase plus per-thread work statistics
+void print_phase_summary();
+
+// Write every recorded span in Chrome trace-event format (chrome://tracing, Perfetto)
+bool write_chrome_trace(const std::string& filename);
+
+#endif
@@ -0,0 +1,296 @@
+#include "libpi.hpp"
+#include "chudnovsky.hpp"
+#include "gauss_legendre.hpp"
+#include "binary_splitting.hpp"
+#include "pi_cache.hpp"
+#include "series_constants.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+PiContext::PiContext(PiOptions options)
+    : opts(std::move(options))
+{
+    if (opts.chunk_size <= 0) opts.chunk_size = 100;
+    if (opts.leaf_size <= 0) opts.leaf_size = 32;
+    if (opts.threads <= 0) opts.threads = 1;
+
+    if (opts.decimal_places > 0)
+    {
+        working_prec = (opts.method != PiMethod::GaussLegendre || opts.constant != PiConstant::Pi)
+            ? get_chudnovsky_precision(opts.decimal_places)
+            : static_cast<mpfr_prec_t>((opts.decimal_places + 5) * 4);
+    }
+}
+
+void PiContext::set_progress_total(long long terms)
+{
+    total.store(terms, std::memory_order_relaxed);
+    done.store(0, std::memory_order_relaxed);
+}
+
+void PiContext::set_progress(long long completed)
+{
+    done.store(completed, std::memory_order_relaxed);
+    if (opts.progress) opts.progress(completed, progress_total());
+}
+
+void PiContext::add_progress(long long completed)
+{
+    long long now = done.fetch_add(completed, std::memory_order_relaxed) + completed;
+    if (opts.progress) opts.progress(now, progress_total());
+}
+
+PiStatus PiContext::compute_value(mpfr_t result)
+{
+    if (opts.decimal_places <= 0) return PiStatus::InvalidArgument;
+
+    mpfr_set_prec(result, working_prec);
+
+    if (opts.constant != PiConstant::Pi)
+    {
+        return calculate_constant_binary_splitting(*this, result);
+    }
+
+    if (opts.method == PiMethod::GaussLegendre)
+    {
+        return calculate_gauss_legendre_algorithm(*this, result);
+    }
+
+    if (opts.method == PiMethod::BinarySplitting)
+    {
+        return calculate_pi_binary_splitting(*this, result);
+    }
+
+    if (opts.threads > 1)
+    {
+        return opts.dynamic ? calculate_pi_chudnovsky_dynamic(*this, result)
+                            : calculate_pi_multithreaded(*this, result);
+    }
+
+    ChudnovskyTermCalculator calculator(working_prec, opts.debug_level);
+    return calculator.calculate_chudnovsky_singlethreaded(*this, result);
+}
+
+PiStatus PiContext::compute(char* buffer, size_t buffer_size)
+{
+    if (opts.decimal_places <= 0 || buffer == nullptr) return PiStatus::InvalidArgument;
+    if (buffer_size < required_buffer_size(opts.decimal_places)) return PiStatus::BufferTooSmall;
+
+    // Digits already in the cache need no computation at all
+    bool use_cache = !opts.cache_dir.empty() && opts.constant == PiConstant::Pi;
+    if (use_cache && cache_read_digits(opts.cache_dir, opts.decimal_places, buffer, buffer_size))
+    {
+        cache_hit = true;
+        return PiStatus::Ok;
+    }
+
+    mpfr_t pi;
+    mpfr_init2(pi, working_prec);
+    PiStatus status = compute_value(pi);
+
+    // Truncate rather than round so the last digit is a digit of the constant
+    if (status == PiStatus::Ok)
+    {
+        status = pi_format_in_base(pi, 10, opts.decimal_places, buffer, buffer_size);
+    }
+
+    mpfr_clear(pi);
+
+    if (status == PiStatus::Ok && use_cache &&
+        !cache_store_digits(opts.cache_dir, buffer, opts.decimal_places))
+    {
+        std::cerr << "⚠️ Warning: Could not store the digits in " << opts.cache_dir << "\n";
+    }
+    return status;
+}
+
+long long pi_digits_in_base(long long decimal_places, int base)
+{
+    if (decimal_places <= 0 || base < 2) return 0;
+    return static_cast<long long>(decimal_places * std::log(10.0) / std::log(static_cast<double>(base)));
+}
+
+PiStatus pi_format_in_base(mpfr_srcptr value, int base, long long digits, char* buffer, size_t buffer_size)
+{
+    if (base < 2 || base > 62 || digits <= 0 || mpfr_sgn(value) < 0) return PiStatus::InvalidArgument;
+
+    // Integer part in base (3 is "11" in base 2, e is "2"); below 1 the text starts "0."
+    unsigned long integer = mpfr_get_ui(value, MPFR_RNDZ);
+    char integer_text[72];
+    {
+        mpz_t whole;
+        mpz_init_set_ui(whole, integer);
+        mpz_get_str(integer_text, base, whole);
+        mpz_clear(whole);
+    }
+    size_t integer_digits = integer ? std::strlen(integer_text) : 0;
+    size_t start = integer ? 0 : 2;
+    size_t length = integer_digits + static_cast<size_t>(digits);      // Digits printed at buffer + start
+
+    // mpfr_get_str wants room for a sign and the NUL
+    if (buffer_size < start + length + 2) return PiStatus::BufferTooSmall;
+    char* text = buffer + start;
+
+    if ((base & (base - 1)) == 0)
+    {
+        // Power of two: shift the mantissa to floor(value * base^digits) and print the integer,
+        // which GMP does in linear time without any division
+        int bits_per_digit = 0;
+        while ((1 << bits_per_digit) < base) ++bits_per_digit;
+
+        mpz_t scaled;
+        mpz_init(scaled);
+        mpfr_exp_t exponent = mpfr_get_z_2exp(scaled, value);
+        long long shift = exponent + digits * bits_per_digit;
+        if (shift >= 0)
+            mpz_mul_2exp(scaled, scaled, shift);
+        else
+            mpz_tdiv_q_2exp(scaled, scaled, -shift);
+
+        // Below 1 the leading fraction digits can be zero
+        size_t printed = mpz_sizeinbase(scaled, base);
+        bool fits = printed <= length && (integer == 0 || printed == length);
+        if (fits)
+        {
+            std::memset(text, '0', length - printed);
+            mpz_get_str(text + (length - printed), base, scaled);
+        }
+        mpz_clear(scaled);
+        if (!fits) return PiStatus::Error;
+    }
+    else
+    {
+        TraceSpan radix_span("radix conversion");
+        mpfr_exp_t exponent = 0;
+        if (mpfr_get_str(text, &exponent, base, length, value, MPFR_RNDZ) == nullptr) return PiStatus::Error;
+
+        if (integer)
+        {
+            if (exponent != static_cast<mpfr_exp_t>(integer_digits)) return PiStatus::Error;
+        }
+        else if (exponent < 0)
+        {
+            // 0.00ddd: shift the significant digits right behind the zeros
+            size_t zeros = std::min<size_t>(-exponent, length);
+            std::memmove(text + zeros, text, length - zeros);
+            std::memset(text, '0', zeros);
+        }
+    }
+
+    size_t point = integer ? integer_digits : 1;
+    if (integer)
+    {
+        // Make room for the point after the integer digits
+        std::memmove(buffer + point + 1, buffer + point, digits);
+    }
+    else
+    {
+        buffer[0] = '0';
+    }
+    buffer[point] = '.';
+    buffer[point + 1 + digits] = '\0';
+    return PiStatus::Ok;
+}
+
+PiStatus pi_format_raw(mpfr_srcptr value, unsigned char* buffer, size_t bytes)
+{
+    if (bytes == 0 || buffer == nullptr) return PiStatus::InvalidArgument;
+
+    mpz_t scaled;
+    mpz_init(scaled);
+    mpfr_exp_t exponent = mpfr_get_z_2exp(scaled, value);
+    long long shift = exponent + static_cast<long long>(bytes) * 8;
+    if (shift >= 0)
+        mpz_mul_2exp(scaled, scaled, shift);
+    else
+        mpz_tdiv_q_2exp(scaled, scaled, -shift);
+    mpz_tdiv_r_2exp(scaled, scaled, bytes * 8);         // Drop the integer part
+
+    // Leading zero bytes of the fraction are not exported, so right align the rest
+    size_t count = (mpz_sizeinbase(scaled, 2) + 7) / 8;
+    std::memset(buffer, 0, bytes);
+    if (mpz_sgn(scaled) != 0) mpz_export(buffer + bytes - count, nullptr, 1, 1, 1, 0, scaled);
+    mpz_clear(scaled);
+    return PiStatus::Ok;
+}
+
+PiStatus PiContext::compute_in_base(int base, char* buffer, size_t buffer_size)
+{
+    if (base == 10) return compute(buffer, buffer_size);
+    if (opts.decimal_places <= 0 || buffer == nullptr || base < 2 || base > 62) return PiStatus::InvalidArgument;
+    if (buffer_size < required_buffer_size_in_base(opts.decimal_places, base)) return PiStatus::BufferTooSmall;
+
+    mpfr_t pi;
+    mpfr_init2(pi, working_prec);
+    PiStatus status = compute_value(pi);
+    if (status == PiStatus::Ok)
+    {
+        status = pi_format_in_base(pi, base, pi_digits_in_base(opts.decimal_places, base), buffer, buffer_size);
+    }
+    mpfr_clear(pi);
+    return status;
+}
+
+PiStatus PiContext::compute_raw(unsigned char* buffer, size_t bytes)
+{
+    if (opts.decimal_places <= 0 || buffer == nullptr) return PiStatus::InvalidArgument;
+    if (bytes > required_raw_bytes(opts.decimal_places)) return PiStatus::InvalidArgument;
+
+    mpfr_t pi;
+    mpfr_init2(pi, working_prec);
+    PiStatus status = compute_value(pi);
+    if (status == PiStatus::Ok)
+    {
+        status = pi_format_raw(pi, buffer, bytes);
+    }
+    mpfr_clear(pi);
+    return status;
+}
+
+const char* pi_status_string(PiStatus status)
+{
+    switch (status)
+    {
+        case PiStatus::Ok:              return "ok";
+        case PiStatus::Cancelled:       return "cancelled";
+        case PiStatus::InvalidArgument: return "invalid argument";
+        case PiStatus::BufferTooSmall:  return "buffer too small";
+        case PiStatus::Error:           return "error";
+    }
+    return "unknown";
+}
+
+static const PiConstant ALL_CONSTANTS[] = {
+    PiConstant::Pi, PiConstant::E, PiConstant::Sqrt2, PiConstant::Log2, PiConstant::Zeta3, PiConstant::Catalan
+};
+
+const char* pi_constant_name(PiConstant constant)
+{
+    switch (constant)
+    {
+        case PiConstant::Pi:        return ChudnovskyPi::name;
+        case PiConstant::E:         return SeriesE::name;
+        case PiConstant::Sqrt2:     return SeriesSqrt2::name;
+        case PiConstant::Log2:      return SeriesLog2::name;
+        case PiConstant::Zeta3:     return SeriesZeta3::name;
+        case PiConstant::Catalan:   return SeriesCatalan::name;
+    }
+    return "unknown";
+}
+
+bool pi_constant_from_name(const std::string& name, PiConstant& constant)
+{
+    for (PiConstant candidate : ALL_CONSTANTS)
+    {
+        if (name == pi_constant_name(candidate))
+        {
+            constant = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,161 @@
+#pragma once
+#ifndef LIBPI_HPP
+#define LIBPI_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include <mpfr.h>
+
+// libpi: the pi engines as a library (libpi.a / libpi.so).
+//
+// Everything a computation needs travels in a PiContext: the options, the thread budget,
+// a cancellation flag and the progress counters. Nothing is kept in globals, so several
+// contexts can compute at the same time in one process.
+//
+//     PiOptions options;
+//     options.decimal_places = 1000000;
+//     options.method = PiMethod::Chudnovsky;
+//     options.threads = 4;
+//     PiContext context(options);
+//     std::vector<char> digits(PiContext::required_buffer_size(options.decimal_places));
+//     PiStatus status = context.compute(digits.data(), digits.size());
+//
+// Diagnostics (traces, perf counters, energy, thread placement) stay process wide and are
+// switched on by the caller; the library only opens spans and pins workers when they are.
+
+enum class PiStatus
+{
+    Ok = 0,
+    Cancelled,              // cancel() was called
+    InvalidArgument,        // Bad options (decimal places <= 0, unknown method ...)
+    BufferTooSmall,         // Caller buffer shorter than required_buffer_size()
+    Error                   // Anything else (allocation failure, I/O ...)
+};
+
+enum class PiMethod
+{
+    GaussLegendre,
+    Chudnovsky,
+    BinarySplitting         // Chudnovsky series by exact binary splitting, extendable through the cache
+};
+
+// What to compute. Everything but Pi is summed by the hypergeometric binary splitting engine,
+// whatever the method.
+enum class PiConstant
+{
+    Pi,
+    E,
+    Sqrt2,
+    Log2,
+    Zeta3,
+    Catalan
+};
+
+// Called with (completed, total) terms or iterations. Runs on the worker threads, so it
+// must be thread safe and quick.
+using PiProgressCallback = std::function<void(long long done, long long total)>;
+
+struct PiOptions
+{
+    long long decimal_places = 0;
+    PiMethod method = PiMethod::GaussLegendre;
+    PiConstant constant = PiConstant::Pi;
+    int threads = 1;                        // Thread budget for Chudnovsky, 1 = run in the calling thread
+    bool dynamic = false;                   // Chudnovsky: hand out chunks of terms instead of fixed ranges
+    int chunk_size = 100;                   // Terms per chunk (dynamic scheduling and trace chunks)
+    int leaf_size = 32;                     // Binary splitting: terms per leaf of the recursion
+    bool factorized = false;                // Binary splitting: cancel common primes of P and Q at each merge
+    std::string merge_dir;                  // Binary splitting: merge shard files from here instead of computing
+    int debug_level = 0;                    // Engine diagnostics on stdout/stderr, 0 = quiet
+    PiProgressCallback progress;            // Optional
+    std::string cache_dir;                  // Result cache for pi (see pi_cache.hpp), empty = none
+
+    // Reference values for term/sum comparison at debug level 3 (see reference_terms.txt),
+    // checked by fingerprint with decimal strings printed only on a mismatch, or always as strings
+    bool fingerprint_checks = true;
+    std::vector<std::string> reference_terms;
+    std::vector<std::string> reference_sums;
+};
+
+// Fractional digits in base (2..62, or 256 for raw bytes) that decimal_places of precision cover
+long long pi_digits_in_base(long long decimal_places, int base);
+
+// Write value (0 <= value < 4) as integer part, "." and digits fractional digits in base 2..62,
+// truncated. buffer_size must be at least digits + 5 (digits + 4 for base 10).
+PiStatus pi_format_in_base(mpfr_srcptr value, int base, long long digits, char* buffer, size_t buffer_size);
+
+// The first bytes * 8 fractional bits of value, most significant first
+PiStatus pi_format_raw(mpfr_srcptr value, unsigned char* buffer, size_t bytes);
+
+class PiContext
+{
+public:
+    explicit PiContext(PiOptions options);
+
+    PiContext(const PiContext&) = delete;
+    PiContext& operator=(const PiContext&) = delete;
+
+    // "3." + decimal_places digits + NUL, plus one byte mpfr_get_str needs while converting
+    static size_t required_buffer_size(long long decimal_places)
+    {
+        return decimal_places + 4 < 7 ? 7 : static_cast<size_t>(decimal_places) + 4;
+    }
+
+    // Compute the constant and write "3.14159..." truncated to decimal_places into buffer
+    PiStatus compute(char* buffer, size_t buffer_size);
+
+    // Integer part, "." and pi_digits_in_base() fractional digits plus NUL
+    static size_t required_buffer_size_in_base(long long decimal_places, int base)
+    {
+        return static_cast<size_t>(pi_digits_in_base(decimal_places, base)) + 5;
+    }
+
+    // Same as compute() in base 2..62 ("3.243f6a88..." for 16). Powers of two need no radix conversion.
+    PiStatus compute_in_base(int base, char* buffer, size_t buffer_size);
+
+    // Fractional bits of pi packed into bytes, most significant first (the bits of the hex digits)
+    static size_t required_raw_bytes(long long decimal_places) { return pi_digits_in_base(decimal_places, 256); }
+    PiStatus compute_raw(unsigned char* buffer, size_t bytes);
+
+    // Compute pi into result (precision is set to precision()), for callers that want the binary value
+    PiStatus compute_value(mpfr_t result);
+
+    // Request cancellation. Safe from any thread and from a signal handler.
+    void cancel() { stop_flag.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return stop_flag.load(std::memory_order_relaxed); }
+
+    long long progress_done() const { return done.load(std::memory_order_relaxed); }
+    long long progress_total() const { return total.load(std::memory_order_relaxed); }
+
+    const PiOptions& options() const { return opts; }
+
+    // Working precision in bits for the chosen method
+    mpfr_prec_t precision() const { return working_prec; }
+
+    // True when the last compute() copied its digits from the cache
+    bool served_from_cache() const { return cache_hit; }
+
+    // ===== used by the engines =====
+    void set_progress_total(long long terms);
+    void set_progress(long long completed);
+    void add_progress(long long completed);
+
+private:
+    PiOptions opts;
+    mpfr_prec_t working_prec = 0;
+    bool cache_hit = false;
+    std::atomic<bool> stop_flag{false};
+    std::atomic<long long> total{0};
+    std::atomic<long long> done{0};
+};
+
+const char* pi_status_string(PiStatus status);
+
+// "pi", "e", "sqrt2", "log2", "zeta3", "catalan"
+const char* pi_constant_name(PiConstant constant);
+bool pi_constant_from_name(const std::string& name, PiConstant& constant);
+
+#endif
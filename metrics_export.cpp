@@ -0,0 +1,152 @@
+#include "metrics_export.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+long get_process_rss_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size_pages = 0, resident_pages = 0;
+    if (!(statm >> size_pages >> resident_pages)) return -1;
+    return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+bool MetricsExporter::open(const std::string& filename, const std::string& requested_format)
+{
+    if (requested_format != "prom" && requested_format != "json")
+    {
+        std::cerr << "Error: Unknown metrics format: " << requested_format << " (use prom or json)\n";
+        return false;
+    }
+
+    if (requested_format == "json")
+    {
+        json_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (json_fd < 0)
+        {
+            std::cerr << "Error: Could not open metrics file " << filename << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+    }
+
+    path = filename;
+    format = requested_format;
+    return true;
+}
+
+void MetricsExporter::close()
+{
+    if (json_fd >= 0) ::close(json_fd);
+    json_fd = -1;
+    path.clear();
+}
+
+void MetricsExporter::write(MetricsSnapshot m)
+{
+    if (!enabled()) return;
+
+    // Throughput since the previous record, ETA from the average rate of the whole run
+    double interval = m.elapsed_seconds - last_elapsed;
+    if (interval > 0)
+    {
+        m.terms_per_second = (m.iteration_counter - last_counter) / interval;
+    }
+    if (m.iteration_counter > 0 && m.elapsed_seconds > 0 && m.iterations >= m.iteration_counter)
+    {
+        double average_rate = m.iteration_counter / m.elapsed_seconds;
+        m.eta_seconds = (m.iterations - m.iteration_counter) / average_rate;
+    }
+    last_elapsed = m.elapsed_seconds;
+    last_counter = m.iteration_counter;
+
+    if (format == "prom")
+        write_prometheus(m);
+    else
+        write_json_line(m);
+}
+
+static void prom_metric(std::ostream& out, const char* name, const char* type, const char* help, double value)
+{
+    out << "# HELP calculate_pi_" << name << " " << help << "\n"
+        << "# TYPE calculate_pi_" << name << " " << type << "\n"
+        << "calculate_pi_" << name << " " << value << "\n";
+}
+
+void MetricsExporter::write_prometheus(const MetricsSnapshot& m)
+{
+    std::ostringstream out;
+    out.precision(15);
+
+    // Labels carry the run description; the phase is an info style metric set to 1
+    out << "# HELP calculate_pi_info Run description\n"
+        << "# TYPE calculate_pi_info gauge\n"
+        << "calculate_pi_info{method=\"" << m.method << "\",phase=\"" << m.phase << "\"} 1\n";
+    prom_metric(out, "decimal_places", "gauge", "Requested decimal places", static_cast<double>(m.decimal_places));
+    prom_metric(out, "progress_total", "gauge", "Terms or iterations required", static_cast<double>(m.iterations));
+    prom_metric(out, "progress_done", "gauge", "Terms or iterations completed", static_cast<double>(m.iteration_counter));
+    prom_metric(out, "progress_ratio", "gauge", "Fraction of terms completed",
+                m.iterations > 0 ? static_cast<double>(m.iteration_counter) / m.iterations : 0.0);
+    prom_metric(out, "elapsed_seconds", "gauge", "Seconds since start", m.elapsed_seconds);
+    prom_metric(out, "terms_per_second", "gauge", "Terms completed per second since the last sample", m.terms_per_second);
+    if (m.eta_seconds >= 0)
+        prom_metric(out, "eta_seconds", "gauge", "Estimated seconds until the series is complete", m.eta_seconds);
+    if (m.rss_kb >= 0)
+        prom_metric(out, "rss_bytes", "gauge", "Resident set size", m.rss_kb * 1024.0);
+    if (m.mem_available_kb >= 0)
+        prom_metric(out, "mem_available_bytes", "gauge", "MemAvailable from /proc/meminfo", m.mem_available_kb * 1024.0);
+    if (m.max_temperature_c > 0)
+        prom_metric(out, "temperature_celsius", "gauge", "Highest hwmon temperature", m.max_temperature_c);
+    if (m.energy_joules >= 0)
+    {
+        prom_metric(out, "energy_joules", "counter", "RAPL energy used since start", m.energy_joules);
+        prom_metric(out, "power_watts", "gauge", "RAPL power at the last sample", m.power_watts);
+    }
+    prom_metric(out, "finished", "gauge", "1 once the computation has finished", m.finished ? 1.0 : 0.0);
+
+    // Write next to the target and rename, which replaces the file atomically
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream tmp(tmp_path, std::ios::trunc);
+        if (!tmp)
+        {
+            std::cerr << "Error: Could not write metrics file " << tmp_path << "\n";
+            return;
+        }
+        tmp << out.str();
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Error: Could not rename " << tmp_path << " to " << path << ": " << std::strerror(errno) << "\n";
+    }
+}
+
+void MetricsExporter::write_json_line(const MetricsSnapshot& m)
+{
+    std::ostringstream out;
+    out.precision(15);
+    out << "{\"method\":\"" << m.method << "\""
+        << ",\"phase\":\"" << m.phase << "\""
+        << ",\"decimal_places\":" << m.decimal_places
+        << ",\"iterations\":" << m.iterations
+        << ",\"iteration_counter\":" << m.iteration_counter
+        << ",\"elapsed_seconds\":" << m.elapsed_seconds
+        << ",\"terms_per_second\":" << m.terms_per_second;
+    if (m.eta_seconds >= 0) out << ",\"eta_seconds\":" << m.eta_seconds;
+    if (m.rss_kb >= 0) out << ",\"rss_bytes\":" << m.rss_kb * 1024LL;
+    if (m.mem_available_kb >= 0) out << ",\"mem_available_bytes\":" << m.mem_available_kb * 1024LL;
+    if (m.max_temperature_c > 0) out << ",\"temperature_celsius\":" << m.max_temperature_c;
+    if (m.energy_joules >= 0) out << ",\"energy_joules\":" << m.energy_joules << ",\"power_watts\":" << m.power_watts;
+    out << ",\"finished\":" << (m.finished ? "true" : "false") << "}\n";
+
+    // One write() per record so concurrent readers only ever see whole lines
+    std::string line = out.str();
+    if (::write(json_fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+    {
+        std::cerr << "Error: Could not append to metrics file " << path << "\n";
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef METRICS_EXPORT_HPP
+#define METRICS_EXPORT_HPP
+
+#include <string>
+
+// Machine-readable progress metrics for fleet tooling (--metrics-file).
+//
+// "prom" rewrites the file in Prometheus textfile format (for node_exporter's textfile
+// collector) by writing a temporary file and renaming it over the target, so a scraper
+// never sees a half written file. "json" appends one JSON object per line with a single
+// write() call on an O_APPEND descriptor.
+
+struct MetricsSnapshot {
+    std::string method;
+    std::string phase;
+    long long decimal_places = 0;
+    long long iterations = 0;               // Total terms (or iterations) expected
+    long long iteration_counter = 0;        // Completed so far
+    double elapsed_seconds = 0.0;
+    double terms_per_second = 0.0;
+    double eta_seconds = -1.0;              // -1 when unknown
+    long rss_kb = -1;
+    long mem_available_kb = -1;
+    float max_temperature_c = 0.0f;         // 0 when no sensor
+    double energy_joules = -1.0;            // -1 when energy accounting is off
+    double power_watts = 0.0;
+    bool finished = false;
+};
+
+class MetricsExporter {
+public:
+    ~MetricsExporter() { close(); }
+
+    // format is "prom" or "json"
+    bool open(const std::string& filename, const std::string& format);
+
+    // Close the JSON lines file after the last record; later writes are dropped
+    void close();
+    bool enabled() const { return !path.empty(); }
+
+    // Fill in rate and ETA from the progress counters and write one record
+    void write(MetricsSnapshot snapshot);
+
+private:
+    void write_prometheus(const MetricsSnapshot& m);
+    void write_json_line(const MetricsSnapshot& m);
+
+    std::string path;
+    std::string format;
+    int json_fd = -1;
+    double last_elapsed = 0.0;
+    long long last_counter = 0;
+};
+
+// Resident set size of this process in KB from /proc/self/statm, -1 if unavailable
+long get_process_rss_kb();
+
+#endif
@@ -0,0 +1,532 @@
+#include "ntt_multiply.hpp"
+#include "self_check.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <immintrin.h>
+
+// Values are kept reduced in [0, p). Multiplication is Montgomery with R = 2^32:
+// mont_mul(a, b) = a b / R mod p, so the twiddle tables hold w R mod p and a product with
+// them is an ordinary modular product. The forward transform is decimation in frequency and
+// leaves its output in bit-reversed order, the inverse is decimation in time and takes its
+// input in that order, so neither needs a bit-reversal pass.
+
+namespace
+{
+
+constexpr unsigned DIGIT_BITS = 16;
+constexpr unsigned DIGITS_PER_LIMB = GMP_NUMB_BITS / DIGIT_BITS;
+constexpr int MAX_LOG_LENGTH = 24;                  // 754974721 = 45 * 2^24 + 1
+
+static_assert(GMP_NUMB_BITS % DIGIT_BITS == 0, "limbs must hold whole digits");
+
+struct NttPrime
+{
+    uint32_t p;
+    uint32_t generator;
+    uint32_t p_inv;                                 // -1/p mod 2^32
+    uint32_t r2;                                    // R^2 mod p
+};
+
+uint32_t pow_mod(uint64_t base, uint64_t exponent, uint32_t p)
+{
+    uint64_t result = 1;
+    base %= p;
+    while (exponent > 0)
+    {
+        if (exponent & 1) result = result * base % p;
+        base = base * base % p;
+        exponent >>= 1;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+NttPrime make_prime(uint32_t p, uint32_t generator)
+{
+    // Newton iteration for 1/p mod 2^32, each step doubles the correct bits
+    uint32_t inverse = p;
+    for (int i = 0; i < 4; ++i) inverse *= 2 - p * inverse;
+
+    uint64_t r = (uint64_t(1) << 32) % p;
+    return {p, generator, static_cast<uint32_t>(0u - inverse), static_cast<uint32_t>(r * r % p)};
+}
+
+const NttPrime PRIMES[3] = {
+    make_prime(167772161, 3),
+    make_prime(469762049, 3),
+    make_prime(754974721, 11),
+};
+
+// ---- Scalar kernels -------------------------------------------------------------------
+
+inline uint32_t mont_mul(uint32_t a, uint32_t b, uint32_t p, uint32_t p_inv)
+{
+    uint64_t t = static_cast<uint64_t>(a) * b;
+    uint32_t m = static_cast<uint32_t>(t) * p_inv;
+    uint32_t u = static_cast<uint32_t>((t + static_cast<uint64_t>(m) * p) >> 32);
+    return u >= p ? u - p : u;
+}
+
+inline uint32_t add_mod(uint32_t a, uint32_t b, uint32_t p)
+{
+    uint32_t sum = a + b;
+    return sum >= p ? sum - p : sum;
+}
+
+inline uint32_t sub_mod(uint32_t a, uint32_t b, uint32_t p)
+{
+    return a >= b ? a - b : a + p - b;
+}
+
+// Forward levels with half-length len down to 1
+void forward_levels_scalar(uint32_t* a, size_t n, size_t len, const NttPrime& prime, const uint32_t* roots)
+{
+    const uint32_t p = prime.p, p_inv = prime.p_inv;
+    for (; len >= 1; len /= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; ++j)
+            {
+                uint32_t u = a[i + j], v = a[i + j + len];
+                a[i + j] = add_mod(u, v, p);
+                a[i + j + len] = mont_mul(sub_mod(u, v, p), roots[len + j], p, p_inv);
+            }
+        }
+    }
+}
+
+// Inverse levels with half-length 1 up to (but not including) len_end
+void inverse_levels_scalar(uint32_t* a, size_t n, size_t len_end, const NttPrime& prime, const uint32_t* roots)
+{
+    const uint32_t p = prime.p, p_inv = prime.p_inv;
+    for (size_t len = 1; len < len_end; len *= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; ++j)
+            {
+                uint32_t u = a[i + j], v = mont_mul(a[i + j + len], roots[len + j], p, p_inv);
+                a[i + j] = add_mod(u, v, p);
+                a[i + j + len] = sub_mod(u, v, p);
+            }
+        }
+    }
+}
+
+void forward_scalar(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    forward_levels_scalar(a, n, n / 2, prime, roots);
+}
+
+void inverse_scalar(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    inverse_levels_scalar(a, n, n, prime, roots);
+}
+
+// a := a b scale / R^2, with scale = R^2 / n folding the inverse transform's 1/n in
+void pointwise_scalar(uint32_t* a, const uint32_t* b, size_t n, const NttPrime& prime, uint32_t scale)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        a[i] = mont_mul(mont_mul(a[i], b[i], prime.p, prime.p_inv), scale, prime.p, prime.p_inv);
+    }
+}
+
+// ---- AVX2 kernels: 8 lanes ------------------------------------------------------------
+
+__attribute__((target("avx2")))
+inline __m256i mont_mul_avx2(__m256i a, __m256i b, __m256i p, __m256i p_inv)
+{
+    // Even lanes in the low halves of the 64-bit products, odd lanes shifted down first
+    __m256i t_even = _mm256_mul_epu32(a, b);
+    __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i m_even = _mm256_mul_epu32(t_even, p_inv);
+    __m256i m_odd = _mm256_mul_epu32(t_odd, p_inv);
+    __m256i u_even = _mm256_srli_epi64(_mm256_add_epi64(t_even, _mm256_mul_epu32(m_even, p)), 32);
+    __m256i u_odd = _mm256_add_epi64(t_odd, _mm256_mul_epu32(m_odd, p));
+    __m256i u = _mm256_blend_epi32(u_even, u_odd, 0xAA);
+    return _mm256_min_epu32(u, _mm256_sub_epi32(u, p));
+}
+
+__attribute__((target("avx2")))
+void forward_avx2(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    const __m256i p = _mm256_set1_epi32(prime.p), p_inv = _mm256_set1_epi32(prime.p_inv);
+    size_t len = n / 2;
+    for (; len >= 8; len /= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j += 8)
+            {
+                __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j));
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j + len));
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(roots + len + j));
+                __m256i sum = _mm256_add_epi32(u, v);
+                sum = _mm256_min_epu32(sum, _mm256_sub_epi32(sum, p));
+                __m256i difference = _mm256_add_epi32(_mm256_sub_epi32(u, v), p);    // In [1, 2p)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i + j), sum);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i + j + len), mont_mul_avx2(difference, w, p, p_inv));
+            }
+        }
+    }
+    forward_levels_scalar(a, n, len, prime, roots);
+}
+
+__attribute__((target("avx2")))
+void inverse_avx2(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    const __m256i p = _mm256_set1_epi32(prime.p), p_inv = _mm256_set1_epi32(prime.p_inv);
+    inverse_levels_scalar(a, n, std::min<size_t>(n, 8), prime, roots);
+    for (size_t len = 8; len < n; len *= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j += 8)
+            {
+                __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j));
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + j + len));
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(roots + len + j));
+                v = mont_mul_avx2(v, w, p, p_inv);
+                __m256i sum = _mm256_add_epi32(u, v);
+                __m256i difference = _mm256_add_epi32(_mm256_sub_epi32(u, v), p);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i + j), _mm256_min_epu32(sum, _mm256_sub_epi32(sum, p)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i + j + len),
+                                    _mm256_min_epu32(difference, _mm256_sub_epi32(difference, p)));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+void pointwise_avx2(uint32_t* a, const uint32_t* b, size_t n, const NttPrime& prime, uint32_t scale)
+{
+    const __m256i p = _mm256_set1_epi32(prime.p), p_inv = _mm256_set1_epi32(prime.p_inv);
+    const __m256i s = _mm256_set1_epi32(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), mont_mul_avx2(mont_mul_avx2(x, y, p, p_inv), s, p, p_inv));
+    }
+    pointwise_scalar(a + i, b + i, n - i, prime, scale);
+}
+
+// ---- AVX-512 kernels: 16 lanes --------------------------------------------------------
+
+// GCC 12 warns about the undefined passthrough operand inside _mm512_mul_epu32
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+inline __m512i mont_mul_avx512(__m512i a, __m512i b, __m512i p, __m512i p_inv)
+{
+    __m512i t_even = _mm512_mul_epu32(a, b);
+    __m512i t_odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+    __m512i m_even = _mm512_mul_epu32(t_even, p_inv);
+    __m512i m_odd = _mm512_mul_epu32(t_odd, p_inv);
+    __m512i u_even = _mm512_srli_epi64(_mm512_add_epi64(t_even, _mm512_mul_epu32(m_even, p)), 32);
+    __m512i u_odd = _mm512_add_epi64(t_odd, _mm512_mul_epu32(m_odd, p));
+    __m512i u = _mm512_mask_blend_epi32(0xAAAA, u_even, u_odd);
+    return _mm512_min_epu32(u, _mm512_sub_epi32(u, p));
+}
+
+__attribute__((target("avx512f")))
+void forward_avx512(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    const __m512i p = _mm512_set1_epi32(prime.p), p_inv = _mm512_set1_epi32(prime.p_inv);
+    size_t len = n / 2;
+    for (; len >= 16; len /= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j += 16)
+            {
+                __m512i u = _mm512_loadu_si512(a + i + j);
+                __m512i v = _mm512_loadu_si512(a + i + j + len);
+                __m512i w = _mm512_loadu_si512(roots + len + j);
+                __m512i sum = _mm512_add_epi32(u, v);
+                sum = _mm512_min_epu32(sum, _mm512_sub_epi32(sum, p));
+                __m512i difference = _mm512_add_epi32(_mm512_sub_epi32(u, v), p);
+                _mm512_storeu_si512(a + i + j, sum);
+                _mm512_storeu_si512(a + i + j + len, mont_mul_avx512(difference, w, p, p_inv));
+            }
+        }
+    }
+    forward_levels_scalar(a, n, len, prime, roots);
+}
+
+__attribute__((target("avx512f")))
+void inverse_avx512(uint32_t* a, size_t n, const NttPrime& prime, const uint32_t* roots)
+{
+    const __m512i p = _mm512_set1_epi32(prime.p), p_inv = _mm512_set1_epi32(prime.p_inv);
+    inverse_levels_scalar(a, n, std::min<size_t>(n, 16), prime, roots);
+    for (size_t len = 16; len < n; len *= 2)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j += 16)
+            {
+                __m512i u = _mm512_loadu_si512(a + i + j);
+                __m512i v = mont_mul_avx512(_mm512_loadu_si512(a + i + j + len), _mm512_loadu_si512(roots + len + j), p, p_inv);
+                __m512i sum = _mm512_add_epi32(u, v);
+                __m512i difference = _mm512_add_epi32(_mm512_sub_epi32(u, v), p);
+                _mm512_storeu_si512(a + i + j, _mm512_min_epu32(sum, _mm512_sub_epi32(sum, p)));
+                _mm512_storeu_si512(a + i + j + len, _mm512_min_epu32(difference, _mm512_sub_epi32(difference, p)));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void pointwise_avx512(uint32_t* a, const uint32_t* b, size_t n, const NttPrime& prime, uint32_t scale)
+{
+    const __m512i p = _mm512_set1_epi32(prime.p), p_inv = _mm512_set1_epi32(prime.p_inv);
+    const __m512i s = _mm512_set1_epi32(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(a + i, mont_mul_avx512(mont_mul_avx512(x, y, p, p_inv), s, p, p_inv));
+    }
+    pointwise_scalar(a + i, b + i, n - i, prime, scale);
+}
+
+#pragma GCC diagnostic pop
+
+// ---- Dispatch -------------------------------------------------------------------------
+
+struct NttKernel
+{
+    const char* name;
+    void (*forward)(uint32_t*, size_t, const NttPrime&, const uint32_t*);
+    void (*inverse)(uint32_t*, size_t, const NttPrime&, const uint32_t*);
+    void (*pointwise)(uint32_t*, const uint32_t*, size_t, const NttPrime&, uint32_t);
+};
+
+const NttKernel SCALAR_KERNEL = {"scalar", forward_scalar, inverse_scalar, pointwise_scalar};
+const NttKernel AVX2_KERNEL = {"avx2", forward_avx2, inverse_avx2, pointwise_avx2};
+const NttKernel AVX512_KERNEL = {"avx512", forward_avx512, inverse_avx512, pointwise_avx512};
+
+const NttKernel* detect_kernel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return &AVX512_KERNEL;
+    if (__builtin_cpu_supports("avx2")) return &AVX2_KERNEL;
+    return &SCALAR_KERNEL;
+}
+
+std::atomic<const NttKernel*> active_kernel{detect_kernel()};
+// Until ntt_configure: on only where the three transforms can run side by side
+const int default_threads = static_cast<int>(std::min(3u, std::max(1u, std::thread::hardware_concurrency())));
+std::atomic<long> threshold_limbs{default_threads >= 3 ? NTT_DEFAULT_THRESHOLD_LIMBS : 0};
+std::atomic<int> transform_threads{default_threads};
+
+// table[len + j] = w^j R mod p for every half-length len < size, w a primitive (2 len)-th
+// root of unity (its inverse for the inverse transform). Entries do not depend on the
+// transform length, so one table per prime and direction serves every length up to its size.
+std::shared_ptr<const std::vector<uint32_t>> build_roots(size_t size, const NttPrime& prime, bool inverse)
+{
+    auto table = std::make_shared<std::vector<uint32_t>>(size, 0);
+    for (size_t len = 1; len < size; len *= 2)
+    {
+        uint32_t w = pow_mod(prime.generator, (prime.p - 1) / (2 * len), prime.p);
+        if (inverse) w = pow_mod(w, prime.p - 2, prime.p);
+
+        uint32_t w_montgomery = mont_mul(w, prime.r2, prime.p, prime.p_inv);
+        uint32_t power = static_cast<uint32_t>((uint64_t(1) << 32) % prime.p);
+        for (size_t j = 0; j < len; ++j)
+        {
+            (*table)[len + j] = power;
+            power = mont_mul(power, w_montgomery, prime.p, prime.p_inv);
+        }
+    }
+    return table;
+}
+
+std::mutex roots_mutex;
+std::shared_ptr<const std::vector<uint32_t>> root_tables[3][2];
+
+// Root table for PRIMES[index] covering length n, grown (doubling) on demand
+std::shared_ptr<const std::vector<uint32_t>> roots_for(int index, size_t n, bool inverse)
+{
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    auto& table = root_tables[index][inverse];
+    if (!table || table->size() < n)
+    {
+        table = build_roots(std::max(n, table ? 2 * table->size() : size_t(1) << 12), PRIMES[index], inverse);
+    }
+    return table;
+}
+
+void load_digits(std::vector<uint32_t>& digits, const mpz_t value, size_t n)
+{
+    digits.assign(n, 0);
+    const mp_limb_t* limbs = mpz_limbs_read(value);
+    size_t size = mpz_size(value);
+    for (size_t i = 0; i < size; ++i)
+    {
+        mp_limb_t limb = limbs[i];
+        for (unsigned d = 0; d < DIGITS_PER_LIMB; ++d)
+        {
+            digits[i * DIGITS_PER_LIMB + d] = static_cast<uint32_t>(limb & 0xFFFF);
+            limb >>= DIGIT_BITS;
+        }
+    }
+}
+
+// The cyclic convolution of the digits of a and b modulo prime, into result
+void convolve(const NttKernel& kernel, int index, const mpz_t a, const mpz_t b, size_t n, std::vector<uint32_t>& result)
+{
+    const NttPrime& prime = PRIMES[index];
+    auto roots = roots_for(index, n, false);
+    std::vector<uint32_t> other;
+    load_digits(result, a, n);
+    kernel.forward(result.data(), n, prime, roots->data());
+    if (a == b)
+    {
+        other = result;
+    }
+    else
+    {
+        load_digits(other, b, n);
+        kernel.forward(other.data(), n, prime, roots->data());
+    }
+
+    // R^2 / n in Montgomery form: the two products in pointwise leave a b / n
+    uint32_t n_inverse = pow_mod(n % prime.p, prime.p - 2, prime.p);
+    uint32_t scale = mont_mul(mont_mul(n_inverse, prime.r2, prime.p, prime.p_inv), prime.r2, prime.p, prime.p_inv);
+    kernel.pointwise(result.data(), other.data(), n, prime, scale);
+
+    roots = roots_for(index, n, true);
+    kernel.inverse(result.data(), n, prime, roots->data());
+}
+
+} // namespace
+
+bool ntt_configure(long threshold, int threads, const std::string& kernel)
+{
+    const NttKernel* selected = nullptr;
+    __builtin_cpu_init();
+    if (kernel == "auto") selected = detect_kernel();
+    else if (kernel == "scalar") selected = &SCALAR_KERNEL;
+    else if (kernel == "avx2" && __builtin_cpu_supports("avx2")) selected = &AVX2_KERNEL;
+    else if (kernel == "avx512" && __builtin_cpu_supports("avx512f")) selected = &AVX512_KERNEL;
+    if (selected == nullptr) return false;
+
+    active_kernel = selected;
+    threshold_limbs = std::max(0L, threshold);
+    transform_threads = std::max(1, threads);
+    return true;
+}
+
+const char* ntt_kernel_name()
+{
+    return active_kernel.load()->name;
+}
+
+long ntt_threshold_limbs()
+{
+    return threshold_limbs;
+}
+
+static void multiply_unchecked(mpz_t result, const mpz_t a, const mpz_t b)
+{
+    long threshold = threshold_limbs;
+    if (threshold > 0 && static_cast<long>(mpz_size(a)) >= threshold && static_cast<long>(mpz_size(b)) >= threshold)
+    {
+        ntt_multiply(result, a, b);
+    }
+    else
+    {
+        mpz_mul(result, a, b);
+    }
+}
+
+void big_multiply(mpz_t result, const mpz_t a, const mpz_t b)
+{
+    checked_multiply(result, a, b, multiply_unchecked);
+}
+
+void ntt_multiply(mpz_t result, const mpz_t a, const mpz_t b)
+{
+    size_t size_a = mpz_size(a), size_b = mpz_size(b);
+    size_t product_digits = (size_a + size_b) * DIGITS_PER_LIMB;
+    if (size_a == 0 || size_b == 0 || product_digits > (size_t(1) << MAX_LOG_LENGTH))
+    {
+        mpz_mul(result, a, b);
+        return;
+    }
+
+    size_t n = 1;
+    while (n < product_digits) n *= 2;
+
+    const NttKernel& kernel = *active_kernel.load();
+    std::vector<uint32_t> residues[3];
+    if (transform_threads >= 2)
+    {
+        std::thread workers[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            workers[i] = std::thread([&, i]() { convolve(kernel, i + 1, a, b, n, residues[i + 1]); });
+        }
+        convolve(kernel, 0, a, b, n, residues[0]);
+        for (auto& worker : workers)
+            worker.join();
+    }
+    else
+    {
+        for (int i = 0; i < 3; ++i)
+            convolve(kernel, i, a, b, n, residues[i]);
+    }
+
+    // Garner: x = r0 + p0 (t1 + p1 t2), each digit product below p0 p1 p2, then carry. The
+    // constants are in Montgomery form so every step is a mont_mul, with no division.
+    const NttPrime& q0 = PRIMES[0];
+    const NttPrime& q1 = PRIMES[1];
+    const NttPrime& q2 = PRIMES[2];
+    auto to_montgomery = [](uint64_t x, const NttPrime& q) { return mont_mul(x % q.p, q.r2, q.p, q.p_inv); };
+    const uint32_t p0_inverse_mod_p1 = to_montgomery(pow_mod(q0.p, q1.p - 2, q1.p), q1);
+    const uint32_t p0_mod_p2 = to_montgomery(q0.p, q2);
+    const uint32_t p01_inverse_mod_p2 = to_montgomery(pow_mod(uint64_t(q0.p) * q1.p % q2.p, q2.p - 2, q2.p), q2);
+    const uint64_t p01 = uint64_t(q0.p) * q1.p;
+
+    size_t limb_count = size_a + size_b;
+    mpz_t product;
+    mpz_init2(product, limb_count * GMP_NUMB_BITS);
+    mp_limb_t* limbs = mpz_limbs_write(product, limb_count);
+
+    unsigned __int128 carry = 0;
+    for (size_t limb = 0; limb < limb_count; ++limb)
+    {
+        mp_limb_t value = 0;
+        for (unsigned d = 0; d < DIGITS_PER_LIMB; ++d)
+        {
+            size_t i = limb * DIGITS_PER_LIMB + d;
+            uint32_t r0 = residues[0][i], r1 = residues[1][i], r2 = residues[2][i];
+            uint32_t t1 = mont_mul(sub_mod(r1, r0, q1.p), p0_inverse_mod_p1, q1.p, q1.p_inv);    // r0 < p0 < p1
+            uint64_t x01 = r0 + uint64_t(q0.p) * t1;
+            uint32_t x01_mod_p2 = add_mod(r0, mont_mul(t1, p0_mod_p2, q2.p, q2.p_inv), q2.p);    // r0 < p2 too
+            uint32_t t2 = mont_mul(sub_mod(r2, x01_mod_p2, q2.p), p01_inverse_mod_p2, q2.p, q2.p_inv);
+
+            carry += x01 + static_cast<unsigned __int128>(p01) * t2;
+            value |= static_cast<mp_limb_t>(carry & 0xFFFF) << (d * DIGIT_BITS);
+            carry >>= DIGIT_BITS;
+        }
+        limbs[limb] = value;
+    }
+
+    // The product fits in limb_count limbs, so the carry is spent; negative when the signs differ
+    mpz_limbs_finish(product, (mpz_sgn(a) * mpz_sgn(b) < 0) ? -static_cast<mp_size_t>(limb_count)
+                                                             : static_cast<mp_size_t>(limb_count));
+    mpz_swap(result, product);
+    mpz_clear(product);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef NTT_MULTIPLY_HPP
+#define NTT_MULTIPLY_HPP
+
+#include <gmp.h>
+#include <string>
+
+// Number-theoretic-transform multiplication for the largest binary splitting products.
+//
+// The operands are cut into 16-bit digits and convolved modulo three NTT primes
+// (167772161, 469762049 and 754974721, product about 2^85.6); the digit products are
+// recovered exactly by the Chinese remainder theorem and carried back into limbs. The
+// three transforms are independent and run on separate threads, which is where this beats
+// GMP's single-threaded FFT. Transform length is limited to 2^24 digits (a product of up
+// to 2^22 limbs, about 80 million decimal digits); larger products go to mpz_mul.
+//
+// The butterfly and pointwise kernels exist in scalar, AVX2 and AVX-512 versions, each
+// compiled with its own target attribute, so one binary runs on any x86-64. The widest
+// one the CPU supports is picked at startup.
+//
+// On one core the NTT measures about twice as slow as mpz_mul; with the transforms on three
+// cores it comes out ahead from a few million digits, so the default threshold applies only
+// when at least three threads are given.
+
+constexpr long NTT_DEFAULT_THRESHOLD_LIMBS = 1L << 18;     // Both operands at least this large (~5M digits)
+
+// Threshold in limbs (0 disables the NTT), threads for the three transforms (1 = run them
+// in the calling thread) and kernel: "auto", "scalar", "avx2" or "avx512". Returns false,
+// keeping the previous settings, when the kernel is unknown or the CPU lacks it.
+bool ntt_configure(long threshold_limbs, int threads, const std::string& kernel);
+
+// Kernel in use: "scalar", "avx2" or "avx512"
+const char* ntt_kernel_name();
+
+long ntt_threshold_limbs();
+
+// result := a * b, by NTT when both operands reach the threshold, otherwise mpz_mul.
+// result may alias a or b. Residue checked with --self-check (see self_check.hpp).
+void big_multiply(mpz_t result, const mpz_t a, const mpz_t b);
+
+// result := a * b by NTT regardless of the threshold (mpz_mul past the length limit)
+void ntt_multiply(mpz_t result, const mpz_t a, const mpz_t b);
+
+#endif
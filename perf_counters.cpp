@@ -0,0 +1,217 @@
+#include "perf_counters.hpp"
+#include "globals.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<bool> perf_active(false);
+
+static std::mutex totals_mutex;
+static std::vector<std::string> phase_order;
+static std::map<std::string, PerfSnapshot> phase_totals;
+
+static const char* counter_labels[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "cache-misses", "branch-misses", "stalled-cycles"
+};
+
+#ifdef __linux__
+
+static long perf_event_open(perf_event_attr* attr, pid_t pid, int cpu, int group_fd, unsigned long flags)
+{
+    return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+// Open one hardware counter for the calling thread, -1 if unavailable
+static int open_counter(unsigned long long config)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;   // Allowed with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(perf_event_open(&attr, 0, -1, -1, 0));
+}
+
+// Counters belonging to one thread, closed when the thread exits
+struct PerfThreadCounters {
+    int fds[PERF_COUNTER_COUNT];
+
+    PerfThreadCounters()
+    {
+        fds[PERF_CYCLES]         = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+        fds[PERF_INSTRUCTIONS]   = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+        fds[PERF_CACHE_MISSES]   = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+        fds[PERF_BRANCH_MISSES]  = open_counter(PERF_COUNT_HW_BRANCH_MISSES);
+        fds[PERF_STALLED_CYCLES] = open_counter(PERF_COUNT_HW_STALLED_CYCLES_BACKEND);
+        if (fds[PERF_STALLED_CYCLES] < 0)
+        {
+            fds[PERF_STALLED_CYCLES] = open_counter(PERF_COUNT_HW_STALLED_CYCLES_FRONTEND);
+        }
+    }
+
+    ~PerfThreadCounters()
+    {
+        for (int fd : fds)
+        {
+            if (fd >= 0) close(fd);
+        }
+    }
+};
+
+static std::string read_paranoid_level()
+{
+    std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+    std::string level;
+    if (!(file >> level)) level = "unknown";
+    return level;
+}
+
+bool perf_counters_enable()
+{
+    int fd = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+    if (fd < 0)
+    {
+        int err = errno;
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "⚠️ Warning: Hardware performance counters unavailable (" << std::strerror(err) << ").\n";
+        if (err == EACCES || err == EPERM)
+        {
+            std::cerr << "ℹ️  HINT: /proc/sys/kernel/perf_event_paranoid is " << read_paranoid_level()
+                      << ". Set it to 2 or lower (or run with CAP_PERFMON) to use --perf-counters.\n";
+        }
+        else if (err == ENOENT || err == EOPNOTSUPP)
+        {
+            std::cerr << "ℹ️  HINT: The CPU or hypervisor does not expose hardware counters.\n";
+        }
+        return false;
+    }
+    close(fd);
+    perf_active.store(true);
+    return true;
+}
+
+PerfSnapshot perf_counters_snapshot()
+{
+    PerfSnapshot snapshot;
+    if (!perf_active.load(std::memory_order_relaxed))
+    {
+        return snapshot;
+    }
+
+    thread_local PerfThreadCounters counters;
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        if (counters.fds[i] < 0) continue;
+
+        // value, time_enabled, time_running
+        unsigned long long data[3] = {0, 0, 0};
+        if (read(counters.fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+
+        // Scale up if the kernel had to multiplex the counter
+        if (data[2] > 0 && data[2] < data[1])
+        {
+            data[0] = static_cast<unsigned long long>(static_cast<double>(data[0]) * data[1] / data[2]);
+        }
+        snapshot.values[i] = data[0];
+    }
+    snapshot.valid = true;
+    return snapshot;
+}
+
+#else
+
+bool perf_counters_enable()
+{
+    std::lock_guard<std::mutex> lock(console_mutex);
+    std::cerr << "⚠️ Warning: --perf-counters is only supported on Linux.\n";
+    return false;
+}
+
+PerfSnapshot perf_counters_snapshot()
+{
+    return PerfSnapshot();
+}
+
+#endif
+
+bool perf_counters_enabled()
+{
+    return perf_active.load(std::memory_order_relaxed);
+}
+
+void perf_counters_accumulate(const char* phase, const PerfSnapshot& begin, const PerfSnapshot& end)
+{
+    if (!begin.valid || !end.valid) return;
+
+    std::lock_guard<std::mutex> lock(totals_mutex);
+    auto it = phase_totals.find(phase);
+    if (it == phase_totals.end())
+    {
+        phase_order.push_back(phase);
+        it = phase_totals.emplace(phase, PerfSnapshot()).first;
+        it->second.valid = true;
+    }
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i)
+    {
+        if (end.values[i] >= begin.values[i])
+        {
+            it->second.values[i] += end.values[i] - begin.values[i];
+        }
+    }
+}
+
+void print_perf_counter_summary()
+{
+    if (!perf_counters_enabled()) return;
+
+    std::lock_guard<std::mutex> totals_lock(totals_mutex);
+    std::lock_guard<std::mutex> lock(console_mutex);
+
+    const int label_width = 18;
+    std::cout << "\n--- Hardware Counters by Phase (all threads) ---\n";
+    std::cout << std::left << std::setw(label_width) << "Phase" << std::right;
+    for (const char* label : counter_labels)
+    {
+        std::cout << std::setw(17) << label;
+    }
+    std::cout << std::setw(8) << "IPC" << std::setw(10) << "MPKI" << std::setw(10) << "stall %" << "\n";
+
+    for (const auto& name : phase_order)
+    {
+        const PerfSnapshot& t = phase_totals[name];
+        std::cout << std::left << std::setw(label_width) << name << std::right;
+        for (unsigned long long value : t.values)
+        {
+            std::cout << std::setw(17) << value;
+        }
+
+        double cycles = static_cast<double>(t.values[PERF_CYCLES]);
+        double instructions = static_cast<double>(t.values[PERF_INSTRUCTIONS]);
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(8) << (cycles > 0 ? instructions / cycles : 0.0)
+                  << std::setw(10) << (instructions > 0 ? 1000.0 * t.values[PERF_CACHE_MISSES] / instructions : 0.0)
+                  << std::setw(10) << (cycles > 0 ? 100.0 * t.values[PERF_STALLED_CYCLES] / cycles : 0.0)
+                  << "\n";
+    }
+    std::cout << "(MPKI = cache misses per 1000 instructions; 0 means the counter is not supported)\n";
+}
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+// Optional hardware performance counters (Linux perf_event_open) attributed to phases.
+//
+// Each thread opens its own counters the first time it takes a snapshot. TraceSpan
+// takes a snapshot when a "phase" or "worker" span opens and closes, and the difference
+// is added to a per-phase total, so the work of all worker threads is summed under "series".
+
+enum PerfCounterId {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_STALLED_CYCLES,
+    PERF_COUNTER_COUNT
+};
+
+struct PerfSnapshot {
+    unsigned long long values[PERF_COUNTER_COUNT] = {};
+    bool valid = false;
+};
+
+// Probe perf_event_open and enable counting. Prints a warning and returns false
+// when the kernel does not allow it (e.g. perf_event_paranoid too high).
+bool perf_counters_enable();
+
+bool perf_counters_enabled();
+
+// Read the calling thread's counters (opens them on first use)
+PerfSnapshot perf_counters_snapshot();
+
+// Add end - begin to the totals for the named phase
+void perf_counters_accumulate(const char* phase, const PerfSnapshot& begin, const PerfSnapshot& end);
+
+// Print cycles, instructions, IPC, cache and branch misses per phase
+void print_perf_counter_summary();
+
+#endif
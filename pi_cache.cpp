@@ -0,0 +1,152 @@
+#include "pi_cache.hpp"
+#include "instrumentation.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static const char DIGITS_FILE[] = "pi_digits.txt";
+static const char SERIES_FILE[] = "chudnovsky.state";
+static const char SERIES_MAGIC[8] = {'P', 'I', 'S', 'E', 'R', 'I', 'E', 'S'};
+static const uint32_t SERIES_VERSION = 1;
+
+// Write through a .tmp file and rename it over path
+template <typename Writer>
+static bool replace_file(const fs::path& path, Writer write)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    std::string temporary = path.string() + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+
+    bool ok = write(file);
+    ok = (std::fflush(file) == 0) && ok;
+    ok = (fsync(fileno(file)) == 0) && ok;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Decimal places stored in the digits file, -1 when there is none
+static long long stored_digits(const fs::path& path)
+{
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec || size < 3) return -1;
+
+    // "3." + digits + "\n"
+    return static_cast<long long>(size) - 3;
+}
+
+bool cache_read_digits(const std::string& dir, long long decimal_places, char* buffer, size_t buffer_size)
+{
+    fs::path path = fs::path(dir) / DIGITS_FILE;
+    if (decimal_places <= 0 || stored_digits(path) < decimal_places) return false;
+
+    size_t length = static_cast<size_t>(decimal_places) + 2;
+    if (buffer_size < length + 1) return false;
+
+    TraceSpan read_span("cache read");
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    bool ok = std::fread(buffer, 1, length, file) == length;
+    std::fclose(file);
+
+    if (!ok || buffer[0] != '3' || buffer[1] != '.') return false;
+    buffer[length] = '\0';
+    return true;
+}
+
+bool cache_store_digits(const std::string& dir, const char* digits, long long decimal_places)
+{
+    fs::path path = fs::path(dir) / DIGITS_FILE;
+    if (stored_digits(path) >= decimal_places) return true;
+
+    TraceSpan write_span("cache write");
+    size_t length = static_cast<size_t>(decimal_places) + 2;
+    return replace_file(path, [&](FILE* file) {
+        return std::fwrite(digits, 1, length, file) == length && std::fputc('\n', file) != EOF;
+    });
+}
+
+bool write_series_file(const std::string& path, const SeriesState& series)
+{
+    return replace_file(path, [&](FILE* file) {
+        uint64_t range[2] = {series.begin, series.end};
+        return std::fwrite(SERIES_MAGIC, 1, sizeof(SERIES_MAGIC), file) == sizeof(SERIES_MAGIC) &&
+               std::fwrite(&SERIES_VERSION, sizeof(SERIES_VERSION), 1, file) == 1 &&
+               std::fwrite(range, sizeof(range), 1, file) == 1 &&
+               mpz_out_raw(file, series.P) != 0 &&
+               mpz_out_raw(file, series.Q) != 0 &&
+               mpz_out_raw(file, series.T) != 0;
+    });
+}
+
+bool read_series_file(const std::string& path, SeriesState& series)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    char magic[sizeof(SERIES_MAGIC)];
+    uint32_t version = 0;
+    uint64_t range[2] = {0, 0};
+    SeriesState loaded;
+
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              std::memcmp(magic, SERIES_MAGIC, sizeof(magic)) == 0 &&
+              std::fread(&version, sizeof(version), 1, file) == 1 && version == SERIES_VERSION &&
+              std::fread(range, sizeof(range), 1, file) == 1 && range[0] <= range[1] &&
+              mpz_inp_raw(loaded.P, file) != 0 &&
+              mpz_inp_raw(loaded.Q, file) != 0 &&
+              mpz_inp_raw(loaded.T, file) != 0;
+    std::fclose(file);
+    if (!ok) return false;
+
+    loaded.begin = range[0];
+    loaded.end = range[1];
+    series.swap(loaded);
+    return true;
+}
+
+bool read_series_range(const std::string& path, unsigned long& begin, unsigned long& end)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    char magic[sizeof(SERIES_MAGIC)];
+    uint32_t version = 0;
+    uint64_t range[2] = {0, 0};
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              std::memcmp(magic, SERIES_MAGIC, sizeof(magic)) == 0 &&
+              std::fread(&version, sizeof(version), 1, file) == 1 && version == SERIES_VERSION &&
+              std::fread(range, sizeof(range), 1, file) == 1 && range[0] <= range[1];
+    std::fclose(file);
+    if (!ok) return false;
+
+    begin = range[0];
+    end = range[1];
+    return true;
+}
+
+bool cache_load_series(const std::string& dir, SeriesState& series)
+{
+    TraceSpan read_span("cache read");
+    return read_series_file((fs::path(dir) / SERIES_FILE).string(), series);
+}
+
+bool cache_store_series(const std::string& dir, const SeriesState& series)
+{
+    TraceSpan write_span("cache write");
+    return write_series_file((fs::path(dir) / SERIES_FILE).string(), series);
+}
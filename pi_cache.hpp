@@ -0,0 +1,33 @@
+#pragma once
+#ifndef PI_CACHE_HPP
+#define PI_CACHE_HPP
+
+#include <cstddef>
+#include <string>
+#include "binary_splitting.hpp"
+
+// Persistent result cache (--cache-dir).
+//
+// The directory holds the largest result computed so far:
+//   pi_digits.txt       "3.14159..." - any smaller request is served from its prefix
+//   chudnovsky.state    binary splitting P, Q, T and the k range they cover, so a larger
+//                       -m binary_splitting request only computes the terms past it
+// Both files are written to a .tmp name and renamed, so a crash never leaves a torn cache.
+
+// Copy "3." plus decimal_places digits and a NUL into buffer when the cache holds enough
+bool cache_read_digits(const std::string& dir, long long decimal_places, char* buffer, size_t buffer_size);
+
+// Store digits ("3.14159...", decimal_places after the point) unless the cache already holds more
+bool cache_store_digits(const std::string& dir, const char* digits, long long decimal_places);
+
+bool cache_load_series(const std::string& dir, SeriesState& series);
+bool cache_store_series(const std::string& dir, const SeriesState& series);
+
+// Self-describing series file: magic, version, k range, then P, Q, T in GMP raw format
+bool write_series_file(const std::string& path, const SeriesState& series);
+bool read_series_file(const std::string& path, SeriesState& series);
+
+// Only the k range of a series file (false when it is not one)
+bool read_series_range(const std::string& path, unsigned long& begin, unsigned long& end);
+
+#endif
@@ -0,0 +1,334 @@
+#include "power_monitor.hpp"
+#include "globals.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static std::vector<RaplDomain> rapl_domains;
+static std::mutex rapl_mutex;                       // Guards rapl_domains and the phase totals
+static std::atomic<bool> energy_enabled(false);
+static std::vector<std::string> energy_phase_order;
+static std::map<std::string, long long> energy_by_phase_uj;
+static long long first_sample_us = 0;
+
+static long long read_file_number(const fs::path& path)
+{
+    std::ifstream file(path);
+    long long value = -1;
+    if (!(file >> value)) return -1;
+    return value;
+}
+
+static std::string read_file_line(const fs::path& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Read power usage from an open energy_uj file
+static long long read_energy_uj(int fd)
+{
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    return std::strtoll(buf, nullptr, 10);
+}
+
+// Discover available RAPL power domains.
+// The zones under /sys/class/powercap are symlinks (intel-rapl:0, intel-rapl:0:0 ...),
+// so list that directory rather than recursing, which does not follow the links.
+static std::vector<RaplDomain> discover_rapl_domains()
+{
+    std::vector<RaplDomain> domains;
+    const std::string base_path = "/sys/class/powercap/";
+    std::error_code ec;
+
+    for (const auto& entry : fs::directory_iterator(base_path, fs::directory_options::skip_permission_denied, ec))
+    {
+        fs::path energy_file = entry.path() / "energy_uj";
+        if (!fs::exists(energy_file, ec)) continue;
+
+        RaplDomain domain;
+        domain.energy_path = energy_file.string();
+        domain.name = read_file_line(entry.path() / "name");
+        domain.max_energy_range_uj = read_file_number(entry.path() / "max_energy_range_uj");
+        domain.fd = open(domain.energy_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (domain.fd < 0 || read_energy_uj(domain.fd) < 0)
+        {
+            if (domain.fd >= 0) close(domain.fd);
+            if (debug_level >= 2)
+            {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                std::cerr << "[discover_rapl_domains] Skipped unreadable domain: " << domain.energy_path << "\n";
+            }
+            continue;
+        }
+
+        if (debug_level >= 3)
+        {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cerr << "[discover_rapl_domains] Usable domain: " << domain.name << " " << domain.energy_path
+                      << " (range " << domain.max_energy_range_uj << " uJ)\n";
+        }
+        domains.push_back(domain);
+    }
+
+    // Packages already include their core and uncore sub-domains; DRAM is separate.
+    // psys covers the whole SoC and would double count, so only fall back to it.
+    bool have_package = std::any_of(domains.begin(), domains.end(),
+        [](const RaplDomain& d) { return d.name.rfind("package", 0) == 0; });
+    for (auto& domain : domains)
+    {
+        if (have_package)
+            domain.counts_toward_total = domain.name.rfind("package", 0) == 0 || domain.name == "dram";
+        else
+            domain.counts_toward_total = domain.name != "core" && domain.name != "uncore";
+    }
+
+    std::sort(domains.begin(), domains.end(),
+        [](const RaplDomain& a, const RaplDomain& b) { return a.energy_path < b.energy_path; });
+
+    if (domains.empty())
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "⚠️ Warning: No readable power domains found. Power monitoring disabled.\n";
+        std::cerr << "ℹ️  HINT: Since Linux 5.10 energy_uj is readable by root only. See README.md (Power Monitoring Permissions).\n";
+    }
+
+    return domains;
+}
+
+static std::string format_domain_label(const std::string& name)
+{
+    if (name == "core") return   "CPU cores";
+    if (name == "uncore") return "CPU other";
+    if (name == "dram") return   "RAM";
+    if (name.rfind("package-", 0) == 0) return "CPU package " + name.substr(8);
+    return name;
+}
+
+bool energy_monitoring_enable()
+{
+    std::vector<RaplDomain> domains = discover_rapl_domains();
+    if (domains.empty()) return false;
+
+    long long now_us = trace_now_us();
+    for (auto& domain : domains)
+    {
+        domain.last_energy_uj = read_energy_uj(domain.fd);
+        domain.last_sample_us = now_us;
+    }
+
+    std::lock_guard<std::mutex> lock(rapl_mutex);
+    rapl_domains = std::move(domains);
+    first_sample_us = now_us;
+    energy_enabled.store(true);
+    return true;
+}
+
+bool energy_monitoring_enabled()
+{
+    return energy_enabled.load(std::memory_order_relaxed);
+}
+
+void monitor_power_usage(const char* phase)
+{
+    if (!energy_monitoring_enabled()) return;
+
+    std::lock_guard<std::mutex> lock(rapl_mutex);
+    long long now_us = trace_now_us();
+    long long phase_uj = 0;
+
+    for (auto& domain : rapl_domains)
+    {
+        long long current = read_energy_uj(domain.fd);
+        if (current < 0) continue;
+
+        long long delta_uj = current - domain.last_energy_uj;
+        if (delta_uj < 0)
+        {
+            // Counter wrapped: it counts up to max_energy_range_uj and restarts from zero
+            delta_uj += (domain.max_energy_range_uj > 0) ? domain.max_energy_range_uj + 1 : (1LL << 32);
+        }
+
+        long long elapsed_us = now_us - domain.last_sample_us;
+        if (elapsed_us > 0)
+        {
+            domain.last_power_watts = static_cast<double>(delta_uj) / static_cast<double>(elapsed_us);
+        }
+
+        domain.accumulated_energy_uj += delta_uj;
+        domain.last_energy_uj = current;
+        domain.last_sample_us = now_us;
+
+        if (domain.counts_toward_total) phase_uj += delta_uj;
+    }
+
+    if (energy_by_phase_uj.find(phase) == energy_by_phase_uj.end())
+    {
+        energy_phase_order.push_back(phase);
+    }
+    energy_by_phase_uj[phase] += phase_uj;
+}
+
+void energy_phase_boundary(const char* finished_phase)
+{
+    monitor_power_usage(finished_phase);
+}
+
+void print_power_usage()
+{
+    std::lock_guard<std::mutex> rapl_lock(rapl_mutex);
+    std::lock_guard<std::mutex> lock(console_mutex);    // Lock console output.
+
+   if (rapl_domains.empty()) {
+        if (debug_level >= 2) {
+            std::cerr << "[Info] No energy data to report (power monitoring disabled).\n";
+        }
+        return; // Nothing to print
+    }
+
+    const int label_width = 15; // Total width to align labels
+
+    double total_power = 0;
+    std::cerr << "\n--- Power Usage by Domain ---\n";
+
+    for (const auto& domain : rapl_domains)
+    {
+        std::string label = format_domain_label(domain.name);
+
+        int padding = label_width - static_cast<int>(label.length());
+        padding = std::max(0, padding); // Prevent negative spacing
+
+        std::cerr << label << std::string(padding, ' ') << ": "
+                  << std::fixed << std::setprecision(5)
+                  << domain.last_power_watts << " W\n";
+
+        if (domain.counts_toward_total) total_power += domain.last_power_watts;
+    }
+
+    std::string total_label = "Total";
+    int total_padding = label_width - static_cast<int>(total_label.length());
+    total_padding = std::max(0, total_padding);
+
+    std::cerr << total_label << std::string(total_padding, ' ') << ": "
+              << std::fixed << std::setprecision(5)
+              << total_power << " W\n";
+}
+
+void print_accumulated_energy()
+{
+    std::lock_guard<std::mutex> rapl_lock(rapl_mutex);
+
+    if (rapl_domains.empty()) {
+        if (debug_level >= 2) {
+            std::cerr << "[Info] No energy data to report (power monitoring disabled).\n";
+        }
+        return; // Nothing to print
+    }
+
+    const int energy_precision = 12;
+    const int label_width = 15; // Total width to right-align labels before ':'
+
+    double total_energy_wh = 0.0;
+    std::cerr << "\n--- Accumulated Energy ---\n";
+
+    for (const auto& domain : rapl_domains)
+    {
+        std::string label = format_domain_label(domain.name);
+
+        double accumulated_energy_wh = domain.accumulated_energy_uj / 3'600'000'000.0;
+        int padding = label_width - static_cast<int>(label.length());
+        padding = std::max(0, padding); // Avoid negative padding
+
+        std::cerr << label << std::string(padding, ' ') << ": "
+                  << std::fixed << std::setprecision(energy_precision)
+                  << accumulated_energy_wh << " Wh\n";
+
+        if (domain.counts_toward_total) total_energy_wh += accumulated_energy_wh;
+    }
+
+    std::string total_label = "Total";
+    int total_padding = label_width - static_cast<int>(total_label.length());
+    total_padding = std::max(0, total_padding);
+
+    std::cerr << total_label << std::string(total_padding, ' ') << ": "
+              << std::fixed << std::setprecision(energy_precision)
+              << total_energy_wh << " Wh\n";
+}
+
+double total_energy_joules()
+{
+    if (!energy_monitoring_enabled()) return -1.0;
+
+    std::lock_guard<std::mutex> lock(rapl_mutex);
+    long long total_uj = 0;
+    for (const auto& domain : rapl_domains)
+    {
+        if (domain.counts_toward_total) total_uj += domain.accumulated_energy_uj;
+    }
+    return total_uj / 1e6;
+}
+
+double total_power_watts()
+{
+    if (!energy_monitoring_enabled()) return 0.0;
+
+    std::lock_guard<std::mutex> lock(rapl_mutex);
+    double watts = 0.0;
+    for (const auto& domain : rapl_domains)
+    {
+        if (domain.counts_toward_total) watts += domain.last_power_watts;
+    }
+    return watts;
+}
+
+void print_energy_report(long long decimal_places)
+{
+    if (!energy_monitoring_enabled()) return;
+
+    double total_j = total_energy_joules();
+
+    std::lock_guard<std::mutex> rapl_lock(rapl_mutex);
+    std::lock_guard<std::mutex> lock(console_mutex);
+
+    const int label_width = 18;
+    std::cout << "\n--- Energy by Phase ---\n";
+    for (const auto& phase : energy_phase_order)
+    {
+        double joules = energy_by_phase_uj[phase] / 1e6;
+        std::cout << std::left << std::setw(label_width) << phase << std::right
+                  << std::setw(14) << std::fixed << std::setprecision(3) << joules << " J"
+                  << std::setw(8) << std::setprecision(1) << (total_j > 0 ? 100.0 * joules / total_j : 0.0) << " %\n";
+    }
+
+    double seconds = (trace_now_us() - first_sample_us) / 1e6;
+    double million_digits = decimal_places / 1e6;
+    std::cout << std::left << std::setw(label_width) << "Total" << std::right
+              << std::setw(14) << std::setprecision(3) << total_j << " J ("
+              << std::setprecision(6) << total_j / 3600.0 << " Wh)\n";
+    if (seconds > 0)
+    {
+        std::cout << "Average power     : " << std::setprecision(2) << total_j / seconds << " W\n";
+    }
+    if (million_digits > 0)
+    {
+        std::cout << "Energy per million digits: " << std::setprecision(3) << total_j / million_digits << " J\n";
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef POWER_MONITOR_HPP
+#define POWER_MONITOR_HPP
+
+#include <string>
+#include <vector>
+
+// RAPL energy accounting from /sys/class/powercap/*/energy_uj.
+//
+// Counters are sampled without blocking: each sample reads every domain once and
+// charges the energy used since the previous sample to the phase that was running.
+// The monitoring thread samples periodically and every phase change samples too,
+// so short phases such as the final division get their own energy figure.
+
+struct RaplDomain
+{
+    std::string name;                       // Contents of the zone's "name" file, e.g. package-0, core, dram
+    std::string energy_path;
+    int fd = -1;                            // energy_uj kept open and re-read with pread
+    long long max_energy_range_uj = 0;      // Counter wraps back to 0 after this value
+    long long last_energy_uj = -1;
+    long long last_sample_us = 0;
+    long long accumulated_energy_uj = 0;
+    double last_power_watts = 0.0;
+    bool counts_toward_total = false;       // False for domains already included in another (core inside package)
+};
+
+// Discover the RAPL domains and take the first reading. Returns false (with a warning)
+// when no domain is readable.
+bool energy_monitoring_enable();
+
+bool energy_monitoring_enabled();
+
+// Read all domains and charge the energy since the last sample to phase
+void monitor_power_usage(const char* phase);
+
+// Called by TraceSpan when the running phase changes
+void energy_phase_boundary(const char* finished_phase);
+
+void print_power_usage();
+void print_accumulated_energy();
+
+// Energy per phase and per million decimal places for the whole run
+void print_energy_report(long long decimal_places);
+
+// Total energy so far in joules (-1 when monitoring is disabled)
+double total_energy_joules();
+
+// Power across counted domains at the last sample, in watts
+double total_power_watts();
+
+#endif
@@ -0,0 +1,144 @@
+#include "prime_factors.hpp"
+
+#include <algorithm>
+
+PrimeSieve::PrimeSieve(uint64_t limit)
+    : smallest(std::max<uint64_t>(limit, 2) + 1, 0)
+{
+    const uint64_t size = smallest.size();
+    for (uint64_t i = 2; i < size; ++i)
+    {
+        if (smallest[i] != 0) continue;
+        smallest[i] = static_cast<uint32_t>(i);
+        for (uint64_t j = i * i; j < size; j += i)
+        {
+            if (smallest[j] == 0) smallest[j] = static_cast<uint32_t>(i);
+        }
+    }
+}
+
+void PrimeSieve::factor(uint64_t n, PrimeFactors& out, uint32_t times) const
+{
+    if (n > limit())
+    {
+        // Series scales: trial division by the sieve's primes, the rest kept whole
+        for (uint64_t d = 2; d <= limit() && d * d <= n; ++d)
+        {
+            if (smallest[d] != d) continue;
+            while (n % d == 0)
+            {
+                out.emplace_back(d, times);
+                n /= d;
+            }
+        }
+        if (n > limit())
+        {
+            out.emplace_back(n, times);
+            return;
+        }
+    }
+
+    while (n > 1)
+    {
+        uint32_t prime = smallest[n];
+        out.emplace_back(prime, times);
+        n /= prime;
+    }
+}
+
+void factors_normalize(PrimeFactors& factors)
+{
+    std::sort(factors.begin(), factors.end());
+    size_t out = 0;
+    for (size_t i = 0; i < factors.size(); ++i)
+    {
+        if (out > 0 && factors[out - 1].first == factors[i].first)
+            factors[out - 1].second += factors[i].second;
+        else
+            factors[out++] = factors[i];
+    }
+    factors.resize(out);
+}
+
+void factors_add(PrimeFactors& into, const PrimeFactors& other)
+{
+    PrimeFactors merged;
+    merged.reserve(into.size() + other.size());
+    size_t i = 0, j = 0;
+    while (i < into.size() || j < other.size())
+    {
+        if (j == other.size() || (i < into.size() && into[i].first < other[j].first))
+            merged.push_back(into[i++]);
+        else if (i == into.size() || other[j].first < into[i].first)
+            merged.push_back(other[j++]);
+        else
+        {
+            merged.emplace_back(into[i].first, into[i].second + other[j].second);
+            ++i;
+            ++j;
+        }
+    }
+    into.swap(merged);
+}
+
+void factors_common(const PrimeFactors& a, const PrimeFactors& b, PrimeFactors& common)
+{
+    common.clear();
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        if (a[i].first < b[j].first) ++i;
+        else if (b[j].first < a[i].first) ++j;
+        else
+        {
+            common.emplace_back(a[i].first, std::min(a[i].second, b[j].second));
+            ++i;
+            ++j;
+        }
+    }
+}
+
+void factors_remove(PrimeFactors& from, const PrimeFactors& common)
+{
+    size_t out = 0, j = 0;
+    for (size_t i = 0; i < from.size(); ++i)
+    {
+        auto entry = from[i];
+        while (j < common.size() && common[j].first < entry.first) ++j;
+        if (j < common.size() && common[j].first == entry.first) entry.second -= common[j].second;
+        if (entry.second > 0) from[out++] = entry;
+    }
+    from.resize(out);
+}
+
+// Product of factors[lo, hi)
+static void product_range(mpz_t value, const PrimeFactors& factors, size_t lo, size_t hi)
+{
+    if (hi - lo <= 8)
+    {
+        mpz_set_ui(value, 1);
+        mpz_t power;
+        mpz_init(power);
+        for (size_t i = lo; i < hi; ++i)
+        {
+            mpz_set_ui(power, factors[i].first);
+            mpz_pow_ui(power, power, factors[i].second);
+            mpz_mul(value, value, power);
+        }
+        mpz_clear(power);
+        return;
+    }
+
+    size_t middle = lo + (hi - lo) / 2;
+    mpz_t right;
+    mpz_init(right);
+    product_range(value, factors, lo, middle);
+    product_range(right, factors, middle, hi);
+    mpz_mul(value, value, right);
+    mpz_clear(right);
+}
+
+void factors_product(mpz_t value, const PrimeFactors& factors)
+{
+    product_range(value, factors, 0, factors.size());
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef PRIME_FACTORS_HPP
+#define PRIME_FACTORS_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <gmp.h>
+
+// Prime factorizations for the factorized binary splitting mode (--factorized).
+//
+// Every p(k) and q(k) is a product of small linear factors, so P and Q of a range can carry
+// their factorization alongside the mpz value. At each merge the primes P1 and Q2 share are
+// divided out of both before multiplying; see series_split_factorized in hypergeometric.hpp.
+
+// (prime, exponent) pairs sorted by prime. A factor of a series scale left over after trial
+// division by the sieve's primes is kept whole as one entry (it shares no prime with the
+// linear factors, all of which the sieve covers).
+using PrimeFactors = std::vector<std::pair<uint64_t, uint32_t>>;
+
+// Smallest prime factor of every n <= limit
+class PrimeSieve
+{
+public:
+    explicit PrimeSieve(uint64_t limit);
+
+    uint64_t limit() const { return smallest.size() - 1; }
+
+    // Append the factorization of n (n <= limit, or any n for small factors and a remainder)
+    // with every exponent multiplied by times. The result is not normalized.
+    void factor(uint64_t n, PrimeFactors& out, uint32_t times = 1) const;
+
+private:
+    std::vector<uint32_t> smallest;
+};
+
+// Sort by prime and add up the exponents of repeated primes
+void factors_normalize(PrimeFactors& factors);
+
+// into := into * other (both normalized)
+void factors_add(PrimeFactors& into, const PrimeFactors& other);
+
+// gcd of a and b: the shared primes with the smaller exponent
+void factors_common(const PrimeFactors& a, const PrimeFactors& b, PrimeFactors& common);
+
+// from := from / common, common dividing from
+void factors_remove(PrimeFactors& from, const PrimeFactors& common);
+
+// value := the product, by a balanced product tree
+void factors_product(mpz_t value, const PrimeFactors& factors);
+
+#endif
@@ -0,0 +1,159 @@
+#include "self_check.hpp"
+#include "globals.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+std::atomic<bool> enabled{false};
+uint64_t primes[2] = {0, 0};
+
+std::atomic<uint64_t> checked_count{0};
+std::atomic<uint64_t> failed_count{0};
+std::atomic<uint64_t> unrecovered_count{0};
+
+struct Residues
+{
+    uint64_t r[2];
+
+    bool operator==(const Residues& other) const { return r[0] == other.r[0] && r[1] == other.r[1]; }
+};
+
+// x mod p for both primes (floor remainder, so negative x works too)
+Residues residues(const mpz_t x)
+{
+    return {{mpz_fdiv_ui(x, primes[0]), mpz_fdiv_ui(x, primes[1])}};
+}
+
+Residues product_of(const Residues& a, const Residues& b)
+{
+    Residues result;
+    for (int i = 0; i < 2; ++i)
+        result.r[i] = static_cast<uint64_t>(static_cast<unsigned __int128>(a.r[i]) * b.r[i] % primes[i]);
+    return result;
+}
+
+Residues sum_of(const Residues& a, const Residues& b)
+{
+    Residues result;
+    for (int i = 0; i < 2; ++i)
+        result.r[i] = static_cast<uint64_t>((static_cast<unsigned __int128>(a.r[i]) + b.r[i]) % primes[i]);
+    return result;
+}
+
+bool applies(const mpz_t a, const mpz_t b)
+{
+    return enabled.load(std::memory_order_relaxed) &&
+           static_cast<long>(mpz_size(a)) >= SELF_CHECK_MIN_LIMBS && static_cast<long>(mpz_size(b)) >= SELF_CHECK_MIN_LIMBS;
+}
+
+void report_failure(const char* operation, const mpz_t a, const mpz_t b, int attempt)
+{
+    failed_count.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(console_mutex);
+    std::cerr << "⚠️ Warning: [SelfCheck] " << operation << " of " << mpz_size(a) << " x " << mpz_size(b)
+              << " limbs failed its residue check (attempt " << attempt << "), redoing it\n";
+}
+
+// Run operation into a temporary until its residues match expected, at most attempts times;
+// the last attempt uses fallback. Then move the result into place.
+template <typename Operation>
+void checked(mpz_t result, const mpz_t a, const mpz_t b, const char* name, const Residues& expected,
+             Operation operation, Operation fallback)
+{
+    checked_count.fetch_add(1, std::memory_order_relaxed);
+    constexpr int ATTEMPTS = 3;
+
+    mpz_t value;
+    mpz_init(value);
+    for (int attempt = 1;; ++attempt)
+    {
+        if (attempt < ATTEMPTS) operation(value, a, b);
+        else fallback(value, a, b);
+
+        if (residues(value) == expected) break;
+        if (attempt == ATTEMPTS)
+        {
+            unrecovered_count.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cerr << "[Error] [SelfCheck] " << name << " of " << mpz_size(a) << " x " << mpz_size(b)
+                      << " limbs still fails its residue check after " << ATTEMPTS << " attempts\n";
+            break;
+        }
+        report_failure(name, a, b, attempt);
+    }
+    mpz_swap(result, value);
+    mpz_clear(value);
+}
+
+} // namespace
+
+void self_check_configure(bool enable)
+{
+    if (enable && primes[0] == 0)
+    {
+        // Random primes in [2^61, 2^62), so no fixed modulus can hide a systematic error
+        std::random_device device;
+        std::mt19937_64 generator((static_cast<uint64_t>(device()) << 32) ^ device());
+        mpz_t candidate;
+        mpz_init(candidate);
+        for (int i = 0; i < 2; ++i)
+        {
+            do
+            {
+                mpz_set_ui(candidate, (generator() >> 3) | (1ULL << 61));
+                mpz_nextprime(candidate, candidate);
+                primes[i] = mpz_get_ui(candidate);
+            } while (i == 1 && primes[1] == primes[0]);
+        }
+        mpz_clear(candidate);
+    }
+    enabled = enable;
+}
+
+bool self_check_enabled()
+{
+    return enabled;
+}
+
+SelfCheckCounts self_check_counts()
+{
+    return {checked_count.load(), failed_count.load(), unrecovered_count.load()};
+}
+
+uint64_t self_check_unrecovered()
+{
+    return unrecovered_count.load();
+}
+
+void self_check_report_discarded(const char* what)
+{
+    std::lock_guard<std::mutex> lock(console_mutex);
+    std::cerr << "[Error] [SelfCheck] An operation failed every redo, " << what << " discarded\n";
+}
+
+void checked_multiply(mpz_t result, const mpz_t a, const mpz_t b, void (*multiply)(mpz_t, const mpz_t, const mpz_t))
+{
+    if (!applies(a, b))
+    {
+        multiply(result, a, b);
+        return;
+    }
+    Residues expected = product_of(residues(a), residues(b));
+    checked(result, a, b, "Product", expected, multiply, static_cast<void (*)(mpz_t, const mpz_t, const mpz_t)>(mpz_mul));
+}
+
+void big_add(mpz_t result, const mpz_t a, const mpz_t b)
+{
+    if (!applies(a, b))
+    {
+        mpz_add(result, a, b);
+        return;
+    }
+    Residues expected = sum_of(residues(a), residues(b));
+    auto add = static_cast<void (*)(mpz_t, const mpz_t, const mpz_t)>(mpz_add);
+    checked(result, a, b, "Sum", expected, add, add);
+}
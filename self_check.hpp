@@ -0,0 +1,46 @@
+#pragma once
+#ifndef SELF_CHECK_HPP
+#define SELF_CHECK_HPP
+
+#include <cstdint>
+#include <gmp.h>
+
+// Residue checks of the big integer arithmetic for long runs (--self-check).
+//
+// A product c = a b is checked modulo two primes picked at random near 2^62 when the run
+// starts: (a mod p)(b mod p) must equal c mod p. The residues cost a few linear passes over
+// the limbs against the superlinear multiplication, so only operands of SELF_CHECK_MIN_LIMBS
+// and up are checked. The result goes to a temporary and is moved into place only once it
+// passes; a failed operation is redone from its intact inputs, first the same way and then with
+// plain mpz_mul in case the NTT path itself is at fault.
+//
+// Binary splitting merges go through big_multiply and big_add, so with the check on every
+// large product and sum of a merge (P1 P2, Q1 Q2, T1 Q2 + P1 T2) is covered.
+
+constexpr long SELF_CHECK_MIN_LIMBS = 1024;                 // Smaller operations are not checked
+
+void self_check_configure(bool enabled);
+bool self_check_enabled();
+
+struct SelfCheckCounts
+{
+    uint64_t checked;               // Operations checked
+    uint64_t failed;                // Checks that failed, each followed by a redo
+    uint64_t unrecovered;           // Operations still wrong after every redo
+};
+
+SelfCheckCounts self_check_counts();
+
+// Operations still wrong after every redo, so far in this process. The engines compare it
+// before and after their work and fail with PiStatus::Error rather than keep or save a wrong
+// result; self_check_report_discarded() says so on stderr.
+uint64_t self_check_unrecovered();
+void self_check_report_discarded(const char* what);
+
+// result := a b by multiply, checked and redone as above when enabled. result may alias a or b.
+void checked_multiply(mpz_t result, const mpz_t a, const mpz_t b, void (*multiply)(mpz_t, const mpz_t, const mpz_t));
+
+// result := a + b, checked the same way when enabled. result may alias a or b.
+void big_add(mpz_t result, const mpz_t a, const mpz_t b);
+
+#endif
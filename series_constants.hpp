@@ -0,0 +1,153 @@
+#pragma once
+#ifndef SERIES_CONSTANTS_HPP
+#define SERIES_CONSTANTS_HPP
+
+#include <array>
+#include <cmath>
+#include <gmp.h>
+#include <mpfr.h>
+
+// Compile-time descriptions of the hypergeometric series the binary splitting engine sums.
+//
+// Each constant is  scale * sum_{k >= 0} (+/-1)^k a(k) prod_{j=1..k} p(j) / q(j)
+// with p and q products of linear factors (slope * j + offset, positive for j >= 1) times a
+// constant, and a(k) a polynomial with non-negative values. finish() turns the sum T / Q
+// into the constant. hypergeometric.hpp instantiates the engine once per description, so
+// the leaves multiply by compile-time constants with no runtime dispatch.
+
+struct LinearFactor
+{
+    unsigned long slope;
+    long offset;
+};
+
+// pi = 426880 sqrt(10005) / sum (-1)^k (6k)! (A + B k) / ((3k)! (k!)^3 C^(3k))    (Chudnovsky)
+struct ChudnovskyPi
+{
+    static constexpr const char* name = "pi";
+    static constexpr unsigned long A = 13591409;
+    static constexpr unsigned long B = 545140134;
+    static constexpr unsigned long C = 640320;
+    static constexpr unsigned long SCALE = 426880;
+    static constexpr unsigned long SQRT_ARGUMENT = 10005;
+
+    static constexpr bool alternating = true;
+    static constexpr unsigned long p_scale = 1;
+    static constexpr std::array<LinearFactor, 3> p_factors{{{6, -5}, {2, -1}, {6, -1}}};
+    static constexpr unsigned long q_scale = 10939058860032000UL;           // C^3 / 24
+    static constexpr std::array<LinearFactor, 3> q_factors{{{1, 0}, {1, 0}, {1, 0}}};
+    static constexpr std::array<unsigned long, 2> a_coefficients{{A, B}};   // a(k) = A + B k
+    static constexpr double digits_per_term = 14.181647462725477;           // log10(C^3 / 1728)
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_sqrt_ui(result, SQRT_ARGUMENT, MPFR_RNDN);
+        mpfr_mul_ui(result, result, SCALE, MPFR_RNDN);
+        mpfr_mul_z(result, result, Q, MPFR_RNDN);
+        mpfr_div_z(result, result, T, MPFR_RNDN);
+    }
+};
+
+// e = sum 1 / k!
+struct SeriesE
+{
+    static constexpr const char* name = "e";
+    static constexpr bool alternating = false;
+    static constexpr unsigned long p_scale = 1;
+    static constexpr std::array<LinearFactor, 0> p_factors{};
+    static constexpr unsigned long q_scale = 1;
+    static constexpr std::array<LinearFactor, 1> q_factors{{{1, 0}}};
+    static constexpr std::array<unsigned long, 1> a_coefficients{{1}};
+    static constexpr double digits_per_term = 0;                            // Grows with k, see terms_for_digits
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_set_z(result, T, MPFR_RNDN);
+        mpfr_div_z(result, result, Q, MPFR_RNDN);
+    }
+};
+
+// sqrt(2) = 7/5 (1 - 1/50)^(-1/2) = 7/5 sum C(2k, k) / 200^k
+struct SeriesSqrt2
+{
+    static constexpr const char* name = "sqrt2";
+    static constexpr bool alternating = false;
+    static constexpr unsigned long p_scale = 1;
+    static constexpr std::array<LinearFactor, 1> p_factors{{{2, -1}}};
+    static constexpr unsigned long q_scale = 100;
+    static constexpr std::array<LinearFactor, 1> q_factors{{{1, 0}}};
+    static constexpr std::array<unsigned long, 1> a_coefficients{{1}};
+    static constexpr double digits_per_term = 1.6989700043360187;           // log10(50)
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_set_z(result, T, MPFR_RNDN);
+        mpfr_mul_ui(result, result, 7, MPFR_RNDN);
+        mpfr_div_z(result, result, Q, MPFR_RNDN);
+        mpfr_div_ui(result, result, 5, MPFR_RNDN);
+    }
+};
+
+// log 2 = 3/4 sum (-1)^k (k!)^2 / (2^k (2k+1)!)
+struct SeriesLog2
+{
+    static constexpr const char* name = "log2";
+    static constexpr bool alternating = true;
+    static constexpr unsigned long p_scale = 1;
+    static constexpr std::array<LinearFactor, 1> p_factors{{{1, 0}}};
+    static constexpr unsigned long q_scale = 4;
+    static constexpr std::array<LinearFactor, 1> q_factors{{{2, 1}}};
+    static constexpr std::array<unsigned long, 1> a_coefficients{{1}};
+    static constexpr double digits_per_term = 0.9030899869919435;           // log10(8)
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_set_z(result, T, MPFR_RNDN);
+        mpfr_mul_ui(result, result, 3, MPFR_RNDN);
+        mpfr_div_z(result, result, Q, MPFR_RNDN);
+        mpfr_div_2ui(result, result, 2, MPFR_RNDN);
+    }
+};
+
+// zeta(3) = 1/64 sum (-1)^k (k!)^10 (205k^2 + 250k + 77) / ((2k+1)!)^5    (Amdeberhan-Zeilberger)
+struct SeriesZeta3
+{
+    static constexpr const char* name = "zeta3";
+    static constexpr bool alternating = true;
+    static constexpr unsigned long p_scale = 1;
+    static constexpr std::array<LinearFactor, 5> p_factors{{{1, 0}, {1, 0}, {1, 0}, {1, 0}, {1, 0}}};
+    static constexpr unsigned long q_scale = 32;
+    static constexpr std::array<LinearFactor, 5> q_factors{{{2, 1}, {2, 1}, {2, 1}, {2, 1}, {2, 1}}};
+    static constexpr std::array<unsigned long, 3> a_coefficients{{77, 250, 205}};
+    static constexpr double digits_per_term = 3.010299956639812;            // log10(1024)
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_set_z(result, T, MPFR_RNDN);
+        mpfr_div_z(result, result, Q, MPFR_RNDN);
+        mpfr_div_2ui(result, result, 6, MPFR_RNDN);
+    }
+};
+
+// Catalan's G = 1/64 sum_{k>=1} (-1)^(k+1) 256^k (40k^2 - 24k + 3) ((2k)!)^3 (k!)^2 / (k^3 (2k-1) ((4k)!)^2)
+// (Lupas), re-indexed from k = j + 1 so that the k^3 (2k-1) denominator folds into the ratio
+struct SeriesCatalan
+{
+    static constexpr const char* name = "catalan";
+    static constexpr bool alternating = true;
+    static constexpr unsigned long p_scale = 32;
+    static constexpr std::array<LinearFactor, 4> p_factors{{{1, 0}, {1, 0}, {1, 0}, {2, -1}}};
+    static constexpr unsigned long q_scale = 1;
+    static constexpr std::array<LinearFactor, 4> q_factors{{{4, 3}, {4, 3}, {4, 1}, {4, 1}}};
+    static constexpr std::array<unsigned long, 3> a_coefficients{{19, 56, 40}};
+    static constexpr double digits_per_term = 0.6020599913279624;           // log10(4)
+
+    static void finish(mpfr_t result, const mpz_t Q, const mpz_t T)
+    {
+        mpfr_set_z(result, T, MPFR_RNDN);
+        mpfr_div_z(result, result, Q, MPFR_RNDN);
+        mpfr_div_ui(result, result, 18, MPFR_RNDN);
+    }
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "series_shards.hpp"
+#include "pi_cache.hpp"
+#include "globals.hpp"
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+std::string shard_file_path(const std::string& dir, int index, int count)
+{
+    std::string name = "pi_shard_" + std::to_string(index) + "_of_" + std::to_string(count) + ".series";
+    return (fs::path(dir.empty() ? "." : dir) / name).string();
+}
+
+PiStatus compute_shard(PiContext& context, int index, int count, const std::string& dir)
+{
+    if (count < 1 || index < 0 || index >= count) return PiStatus::InvalidArgument;
+
+    const PiOptions& options = context.options();
+    unsigned long terms = chudnovsky_terms_for_digits(options.decimal_places);
+    unsigned long begin = terms * index / count;
+    unsigned long end = terms * (index + 1) / count;
+
+    if (options.debug_level >= 1)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Shard] " << index << "/" << count << ": terms " << begin << " .. " << end << " of " << terms << "\n";
+    }
+
+    context.set_progress_total(end - begin);
+    SeriesState series;
+    PiStatus status = binary_split_range(context, begin, end, series);
+    if (status != PiStatus::Ok) return status;
+
+    TraceSpan write_span("shard write");
+    std::string path = shard_file_path(dir, index, count);
+    if (!write_series_file(path, series))
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Error] Could not write shard file " << path << "\n";
+        return PiStatus::Error;
+    }
+    return PiStatus::Ok;
+}
+
+namespace
+{
+
+struct ShardFile
+{
+    std::string path;
+    unsigned long begin;
+    unsigned long end;
+};
+
+} // namespace
+
+PiStatus merge_shards(const std::string& dir, unsigned long terms, SeriesState& series, int debug_level)
+{
+    std::vector<ShardFile> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir.empty() ? "." : dir, ec))
+    {
+        if (entry.path().extension() != ".series") continue;
+        ShardFile file{entry.path().string(), 0, 0};
+        if (read_series_range(file.path, file.begin, file.end) && file.begin < file.end) files.push_back(file);
+    }
+    if (ec)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Error] Cannot read shard directory " << dir << ": " << ec.message() << "\n";
+        return PiStatus::Error;
+    }
+
+    // Breadth first search over k, each file an edge from its begin to its end. The first path
+    // to reach the needed terms uses the fewest files; shards left over from a split with a
+    // different N are simply not on it.
+    std::sort(files.begin(), files.end(), [](const ShardFile& a, const ShardFile& b) { return a.begin < b.begin; });
+    std::map<unsigned long, const ShardFile*> reached_by;      // k -> file ending there, nullptr for k = 0
+    reached_by[0] = nullptr;
+    std::deque<unsigned long> queue = {0};
+    unsigned long covered = 0;
+    while (!queue.empty() && covered < terms)
+    {
+        unsigned long k = queue.front();
+        queue.pop_front();
+        auto first = std::lower_bound(files.begin(), files.end(), k,
+                                      [](const ShardFile& file, unsigned long value) { return file.begin < value; });
+        for (auto file = first; file != files.end() && file->begin == k; ++file)
+        {
+            if (!reached_by.emplace(file->end, &*file).second) continue;
+            if (file->end >= terms)
+            {
+                covered = file->end;
+                break;
+            }
+            queue.push_back(file->end);
+        }
+    }
+
+    if (covered < terms)
+    {
+        unsigned long furthest = reached_by.rbegin()->first;
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Error] No set of shard files in " << dir << " covers the " << terms << " terms needed: "
+                  << "they reach k = " << furthest << " at most, missing a shard starting there\n";
+        return PiStatus::InvalidArgument;
+    }
+
+    std::vector<const ShardFile*> chain;
+    for (unsigned long k = covered; k != 0; k = chain.back()->begin)
+    {
+        chain.push_back(reached_by[k]);
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    std::vector<SeriesState> parts(chain.size());
+    {
+        TraceSpan read_span("shard read");
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            if (!read_series_file(chain[i]->path, parts[i]))
+            {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                std::cerr << "[Error] Could not read shard file " << chain[i]->path << "\n";
+                return PiStatus::Error;
+            }
+            if (debug_level >= 1)
+            {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                std::cerr << "[Shard] " << chain[i]->path << ": terms " << parts[i].begin << " .. " << parts[i].end << "\n";
+            }
+        }
+    }
+
+    // Neighbours pairwise, so operands stay balanced
+    TraceSpan merge_span("merge");
+    while (parts.size() > 1)
+    {
+        std::vector<SeriesState> next((parts.size() + 1) / 2);
+        for (size_t i = 0; i < parts.size(); i += 2)
+        {
+            next[i / 2].swap(parts[i]);
+            if (i + 1 < parts.size()) merge_series(next[i / 2], parts[i + 1]);
+        }
+        parts.swap(next);
+    }
+
+    series.swap(parts[0]);
+    return PiStatus::Ok;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef SERIES_SHARDS_HPP
+#define SERIES_SHARDS_HPP
+
+#include <string>
+#include "binary_splitting.hpp"
+#include "libpi.hpp"
+
+// Sharded binary splitting across processes or hosts (--shard i/N, --merge).
+//
+// Shard i of N computes the Chudnovsky terms [K i / N, K (i + 1) / N), K the terms for the
+// requested digits, and writes them as a series file (see write_series_file: magic, version,
+// k range, P, Q, T) named pi_shard_<i>_of_<N>.series. The shards share nothing but the
+// directory, so they can run as local processes or on other hosts with the files copied in.
+//
+// Merging reads the k range of every *.series file in the directory, picks files that tile
+// [0, K) without gaps (shards of different N mix freely) and combines them pairwise.
+
+std::string shard_file_path(const std::string& dir, int index, int count);
+
+// Compute shard index (0 based) of count for the context's decimal places and write its file
+PiStatus compute_shard(PiContext& context, int index, int count, const std::string& dir);
+
+// The series for terms [0, terms) or more from the shard files in dir. InvalidArgument when
+// they do not cover the range.
+PiStatus merge_shards(const std::string& dir, unsigned long terms, SeriesState& series, int debug_level);
+
+#endif
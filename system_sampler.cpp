@@ -0,0 +1,189 @@
+#include "system_sampler.hpp"
+#include "globals.hpp"
+#include "instrumentation.hpp"
+#include "container_limits.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Read a small sysfs/procfs file into buf from offset 0, returns bytes read or -1
+static ssize_t read_small_file(int fd, char* buf, size_t size)
+{
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n < 0) return -1;
+    buf[n] = '\0';
+    return n;
+}
+
+static std::string read_first_line(const fs::path& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+SystemSampler::SystemSampler(size_t capacity)
+    : ring(std::max<size_t>(capacity, 1))
+{
+}
+
+SystemSampler::~SystemSampler()
+{
+    for (int fd : temp_fds) close(fd);
+    for (int fd : freq_fds) close(fd);
+    if (meminfo_fd >= 0) close(meminfo_fd);
+    if (cgroup_usage_fd >= 0) close(cgroup_usage_fd);
+}
+
+void SystemSampler::discover()
+{
+    std::error_code ec;
+
+    // Temperatures: every hwmon temp*_input, labelled by temp*_label or the chip name
+    for (const auto& hwmon : fs::directory_iterator("/sys/class/hwmon", ec))
+    {
+        std::string chip = read_first_line(hwmon.path() / "name");
+        std::vector<fs::path> inputs;
+        for (const auto& entry : fs::directory_iterator(hwmon.path(), ec))
+        {
+            std::string file = entry.path().filename().string();
+            if (file.rfind("temp", 0) == 0 && file.size() > 10 && file.compare(file.size() - 6, 6, "_input") == 0)
+            {
+                inputs.push_back(entry.path());
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+
+        for (const auto& input : inputs)
+        {
+            if (temp_fds.size() >= static_cast<size_t>(MAX_TEMPERATURE_SENSORS)) break;
+
+            int fd = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+
+            std::string base = input.filename().string();
+            base = base.substr(0, base.size() - 6);     // strip "_input"
+            std::string label = read_first_line(input.parent_path() / (base + "_label"));
+            if (label.empty()) label = chip.empty() ? base : chip + " " + base;
+
+            temp_fds.push_back(fd);
+            temp_labels.push_back(label);
+        }
+    }
+
+    // CPU frequency per logical CPU
+    for (const auto& cpu : fs::directory_iterator("/sys/devices/system/cpu", ec))
+    {
+        std::string name = cpu.path().filename().string();
+        if (name.rfind("cpu", 0) != 0 || name.size() < 4 || !std::isdigit(static_cast<unsigned char>(name[3]))) continue;
+
+        fs::path freq = cpu.path() / "cpufreq" / "scaling_cur_freq";
+        int fd = open(freq.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) freq_fds.push_back(fd);
+    }
+
+    meminfo_fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+
+    if (container_limits().memory_limit_bytes > 0)
+    {
+        cgroup_usage_fd = open(container_memory_usage_path().c_str(), O_RDONLY | O_CLOEXEC);
+        cgroup_limit_kb = static_cast<long>(container_limits().memory_limit_bytes / 1024);
+    }
+
+    if (debug_level >= 2)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[SystemSampler] " << temp_fds.size() << " temperature sensors, "
+                  << freq_fds.size() << " cpufreq sources, meminfo "
+                  << (meminfo_fd >= 0 ? "available" : "unavailable") << "\n";
+    }
+}
+
+const SystemSample& SystemSampler::take_sample()
+{
+    SystemSample& s = ring[next];
+    s = SystemSample();
+    s.time_us = trace_now_us();
+
+    char buf[4096];
+
+    for (int fd : temp_fds)
+    {
+        if (read_small_file(fd, buf, 64) <= 0) continue;
+        float celsius = std::strtol(buf, nullptr, 10) / 1000.0f;   // millidegrees
+        s.temperatures_c[s.temperature_count++] = celsius;       // Unreadable sensors leave no slot
+        s.max_temperature_c = std::max(s.max_temperature_c, celsius);
+    }
+
+    int freq_count = 0;
+    float freq_sum = 0.0f;
+    for (int fd : freq_fds)
+    {
+        if (read_small_file(fd, buf, 64) <= 0) continue;
+        float mhz = std::strtol(buf, nullptr, 10) / 1000.0f;     // kHz
+        freq_sum += mhz;
+        s.max_frequency_mhz = std::max(s.max_frequency_mhz, mhz);
+        ++freq_count;
+    }
+    if (freq_count > 0) s.avg_frequency_mhz = freq_sum / freq_count;
+
+    if (meminfo_fd >= 0 && read_small_file(meminfo_fd, buf, sizeof(buf)) > 0)
+    {
+        const char* line = std::strstr(buf, "MemAvailable:");
+        if (line != nullptr)
+        {
+            s.mem_available_kb = std::strtol(line + std::strlen("MemAvailable:"), nullptr, 10);
+        }
+    }
+
+    if (cgroup_usage_fd >= 0 && read_small_file(cgroup_usage_fd, buf, 64) > 0)
+    {
+        long headroom_kb = cgroup_limit_kb - static_cast<long>(std::strtoll(buf, nullptr, 10) / 1024);
+        if (s.mem_available_kb < 0 || headroom_kb < s.mem_available_kb) s.mem_available_kb = std::max(0L, headroom_kb);
+    }
+
+    next = (next + 1) % ring.size();
+    if (count < ring.size()) ++count;
+    return s;
+}
+
+bool SystemSampler::latest(SystemSample& out) const
+{
+    if (count == 0) return false;
+    out = ring[(next + ring.size() - 1) % ring.size()];
+    return true;
+}
+
+void SystemSampler::summarize(float& peak_temperature_c, long& min_mem_available_kb, float& avg_frequency_mhz) const
+{
+    peak_temperature_c = 0.0f;
+    min_mem_available_kb = -1;
+    avg_frequency_mhz = 0.0f;
+
+    int freq_samples = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const SystemSample& s = ring[i];
+        peak_temperature_c = std::max(peak_temperature_c, s.max_temperature_c);
+        if (s.mem_available_kb >= 0 && (min_mem_available_kb < 0 || s.mem_available_kb < min_mem_available_kb))
+        {
+            min_mem_available_kb = s.mem_available_kb;
+        }
+        if (s.avg_frequency_mhz > 0)
+        {
+            avg_frequency_mhz += s.avg_frequency_mhz;
+            ++freq_samples;
+        }
+    }
+    if (freq_samples > 0) avg_frequency_mhz /= freq_samples;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef SYSTEM_SAMPLER_HPP
+#define SYSTEM_SAMPLER_HPP
+
+#include <string>
+#include <vector>
+
+// In-process sampler for CPU temperature, CPU frequency and free memory.
+//
+// Reads /sys/class/hwmon/*/temp*_input, /sys/devices/system/cpu/cpu*/cpufreq/scaling_cur_freq
+// and /proc/meminfo directly. All files are opened once by discover() and re-read with pread,
+// and samples go into a ring buffer allocated up front, so a sample does no allocation
+// and never forks a process. Under a cgroup memory limit the free memory figure is capped
+// by the cgroup's headroom, since MemAvailable describes the whole host.
+
+constexpr int MAX_TEMPERATURE_SENSORS = 64;
+
+struct SystemSample {
+    long long time_us = 0;                              // trace_now_us() when taken
+    int temperature_count = 0;
+    float temperatures_c[MAX_TEMPERATURE_SENSORS] = {};
+    float max_temperature_c = 0.0f;                     // 0 when no sensor is readable
+    float avg_frequency_mhz = 0.0f;                     // 0 when cpufreq is not available
+    float max_frequency_mhz = 0.0f;
+    long mem_available_kb = -1;
+};
+
+class SystemSampler {
+public:
+    explicit SystemSampler(size_t capacity = 1024);
+    ~SystemSampler();
+
+    SystemSampler(const SystemSampler&) = delete;
+    SystemSampler& operator=(const SystemSampler&) = delete;
+
+    // Find and open the sensor files. Safe to call once before sampling.
+    void discover();
+
+    // Read all sensors now and append the sample to the ring buffer
+    const SystemSample& take_sample();
+
+    // Most recent sample, false if none has been taken
+    bool latest(SystemSample& out) const;
+
+    size_t sample_count() const { return count; }
+    const std::vector<std::string>& temperature_labels() const { return temp_labels; }
+    size_t frequency_sources() const { return freq_fds.size(); }
+
+    // Peak temperature, lowest free memory and average frequency over the samples held
+    void summarize(float& peak_temperature_c, long& min_mem_available_kb, float& avg_frequency_mhz) const;
+
+private:
+    std::vector<SystemSample> ring;
+    size_t next = 0;
+    size_t count = 0;
+
+    std::vector<int> temp_fds;
+    std::vector<std::string> temp_labels;
+    std::vector<int> freq_fds;
+    int meminfo_fd = -1;
+    int cgroup_usage_fd = -1;                   // memory.current / memory.usage_in_bytes
+    long cgroup_limit_kb = -1;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "thread_placement.hpp"
+#include "globals.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace fs = std::filesystem;
+
+static std::vector<PlacementCpu> worker_cpus;   // Worker i runs on worker_cpus[i % size]
+static std::vector<int> node_ids;               // Distinct nodes of worker_cpus, ascending
+static bool placement_on = false;
+static bool numa_on = false;
+
+static int read_int_file(const std::string& path, int fallback)
+{
+    std::ifstream file(path);
+    int value = fallback;
+    if (!(file >> value)) return fallback;
+    return value;
+}
+
+// Parse a sysfs cpu list such as "0-3,8-11"
+static std::vector<int> parse_cpu_list(const std::string& list)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t comma = list.find(',', pos);
+        std::string range = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = range.find('-');
+        try
+        {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        catch (const std::exception&)
+        {
+            // Empty or malformed entry, skip it
+        }
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return cpus;
+}
+
+// Map of cpu -> node from /sys/devices/system/node/node*/cpulist (empty on non-NUMA kernels)
+static std::map<int, int> read_cpu_nodes()
+{
+    std::map<int, int> cpu_node;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() < 5 || !std::isdigit(static_cast<unsigned char>(name[4]))) continue;
+
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(file, list)) continue;
+        int node = std::stoi(name.substr(4));
+        for (int cpu : parse_cpu_list(list)) cpu_node[cpu] = node;
+    }
+    return cpu_node;
+}
+
+bool placement_configure(bool skip_smt, bool numa)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        std::cerr << "⚠️ Warning: sched_getaffinity failed (" << std::strerror(errno) << "). Threads will not be pinned.\n";
+        return false;
+    }
+
+    std::map<int, int> cpu_node = read_cpu_nodes();
+    std::vector<PlacementCpu> cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+
+        std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        PlacementCpu entry;
+        entry.cpu = cpu;
+        entry.package = read_int_file(topology + "physical_package_id", 0);
+        entry.core = read_int_file(topology + "core_id", cpu);
+        auto node = cpu_node.find(cpu);
+        entry.node = (node != cpu_node.end()) ? node->second : 0;
+
+        // The lowest numbered thread of a core is its primary; the others are SMT siblings
+        std::ifstream siblings_file(topology + "thread_siblings_list");
+        std::string siblings;
+        if (std::getline(siblings_file, siblings))
+        {
+            std::vector<int> siblings_list = parse_cpu_list(siblings);
+            if (!siblings_list.empty())
+                entry.smt_sibling = cpu != *std::min_element(siblings_list.begin(), siblings_list.end());
+        }
+        cpus.push_back(entry);
+    }
+
+    if (cpus.empty())
+    {
+        std::cerr << "⚠️ Warning: No usable CPUs found in the affinity mask. Threads will not be pinned.\n";
+        return false;
+    }
+
+    // Compact order: fill a node core by core, first hardware threads before siblings
+    std::stable_sort(cpus.begin(), cpus.end(), [](const PlacementCpu& a, const PlacementCpu& b) {
+        if (a.node != b.node) return a.node < b.node;
+        if (a.smt_sibling != b.smt_sibling) return !a.smt_sibling;
+        if (a.package != b.package) return a.package < b.package;
+        if (a.core != b.core) return a.core < b.core;
+        return a.cpu < b.cpu;
+    });
+
+    if (skip_smt)
+    {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                  [](const PlacementCpu& c) { return c.smt_sibling; }), cpus.end());
+    }
+
+    worker_cpus = std::move(cpus);
+    node_ids.clear();
+    for (const auto& c : worker_cpus)
+    {
+        if (std::find(node_ids.begin(), node_ids.end(), c.node) == node_ids.end()) node_ids.push_back(c.node);
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+
+    placement_on = true;
+    numa_on = numa;
+
+    if (debug_level >= 1)
+    {
+        std::cerr << "[Placement] " << worker_cpus.size() << " CPUs on " << node_ids.size() << " NUMA node(s)"
+                  << (skip_smt ? ", SMT siblings skipped" : "") << (numa ? ", NUMA memory policy on" : "") << "\n";
+    }
+    return true;
+}
+
+bool placement_enabled()
+{
+    return placement_on;
+}
+
+bool placement_numa_enabled()
+{
+    return placement_on && numa_on;
+}
+
+int placement_cpu_count()
+{
+    return static_cast<int>(worker_cpus.size());
+}
+
+int placement_node_count()
+{
+    return placement_on ? static_cast<int>(node_ids.size()) : 1;
+}
+
+int placement_node_of_worker(int worker_index)
+{
+    if (!placement_on) return 0;
+    return worker_cpus[worker_index % worker_cpus.size()].node;
+}
+
+// Prefer node for pages this thread faults in from now on
+static void prefer_node(int node)
+{
+    unsigned long mask[16] = {};
+    const unsigned long bits = sizeof(unsigned long) * 8;
+    if (node < 0 || static_cast<unsigned long>(node) >= bits * 16) return;
+    mask[node / bits] |= 1UL << (node % bits);
+
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, bits * 16) != 0 && debug_level >= 2)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Placement] set_mempolicy failed: " << std::strerror(errno) << "\n";
+    }
+}
+
+static void pin_to(const cpu_set_t& set, const char* what)
+{
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0 && debug_level >= 1)
+    {
+        std::lock_guard<std::mutex> lock(console_mutex);
+        std::cerr << "[Placement] Could not pin " << what << ": " << std::strerror(rc) << "\n";
+    }
+}
+
+void placement_apply(int worker_index)
+{
+    if (!placement_on) return;
+
+    const PlacementCpu& target = worker_cpus[worker_index % worker_cpus.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(target.cpu, &set);
+    pin_to(set, "worker");
+
+    if (numa_on) prefer_node(target.node);
+}
+
+void placement_apply_node(int node)
+{
+    if (!placement_on) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto& c : worker_cpus)
+    {
+        if (c.node == node) CPU_SET(c.cpu, &set);
+    }
+    if (CPU_COUNT(&set) == 0) return;
+    pin_to(set, "merge thread");
+
+    if (numa_on) prefer_node(node);
+}
+
+void print_placement_plan(int worker_count)
+{
+    if (!placement_on) return;
+
+    std::lock_guard<std::mutex> lock(console_mutex);
+    std::cerr << "[Placement] Worker -> CPU (node):";
+    for (int i = 0; i < worker_count; ++i)
+    {
+        const PlacementCpu& c = worker_cpus[i % worker_cpus.size()];
+        std::cerr << " " << i << "->" << c.cpu << "(" << c.node << ")";
+    }
+    std::cerr << "\n";
+    if (worker_count > static_cast<int>(worker_cpus.size()))
+    {
+        std::cerr << "⚠️ Warning: " << worker_count << " workers on " << worker_cpus.size()
+                  << " CPUs, some CPUs run more than one worker.\n";
+    }
+}
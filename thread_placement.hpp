@@ -0,0 +1,50 @@
+#pragma once
+#ifndef THREAD_PLACEMENT_HPP
+#define THREAD_PLACEMENT_HPP
+
+#include <vector>
+
+// CPU affinity and NUMA placement for the Chudnovsky worker threads (--pin, --skip-smt, --numa).
+//
+// The usable CPUs (those in the process affinity mask, so taskset and cpusets are honoured)
+// are ordered node by node and core by core. Worker i runs on the i-th CPU of that list, so
+// neighbouring workers share a node. A pinned worker first-touches its scratchpad and partial
+// sum, which puts those pages on its own node; --numa also sets a preferred memory policy
+// for the thread and merges the partial sums node by node before crossing sockets.
+
+struct PlacementCpu
+{
+    int cpu = -1;
+    int node = 0;
+    int package = 0;
+    int core = 0;
+    bool smt_sibling = false;       // Not the first hardware thread of its core
+};
+
+// Discover the topology and build the worker CPU list. Returns false (with a warning) when
+// the topology cannot be read, in which case threads are left unplaced.
+bool placement_configure(bool skip_smt, bool numa);
+
+bool placement_enabled();
+bool placement_numa_enabled();
+
+// Number of CPUs workers are placed on (physical cores only with --skip-smt)
+int placement_cpu_count();
+
+// Number of NUMA nodes the worker CPUs span
+int placement_node_count();
+
+// NUMA node worker_index runs on (0 when placement is off)
+int placement_node_of_worker(int worker_index);
+
+// Pin the calling thread to the CPU of worker_index and, with --numa, prefer its node for
+// new allocations. Call at the start of the worker, before it allocates its scratch memory.
+void placement_apply(int worker_index);
+
+// Pin the calling thread to any CPU of node (used by the per-node merge threads)
+void placement_apply_node(int node);
+
+// Print which CPU and node each worker uses
+void print_placement_plan(int worker_count);
+
+#endif